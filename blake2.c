@@ -0,0 +1,307 @@
+#include "blake2.h"
+
+/*
+ * blake2s and blake2b from RFC7693
+ * both are unkeyed and use their full digest size, 32 and 64 bytes
+ */
+
+/*
+ * initial state, the same words as sha256 and sha512
+ */
+static const uint32_t blake2s_iv[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const uint64_t blake2b_iv[8] =
+{
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+    0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+/*
+ * message word order of every round
+ * blake2b has 12 rounds and repeats the first two
+ */
+static const uint8_t blake2_sigma[12][16] =
+{
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+    {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+    {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+    {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+    {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+    {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+    {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+    {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+    {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3}
+};
+
+/*
+ * right rotations on 32bit and 64bit unsigned ints
+ */
+static uint32_t blake2s_rot(uint32_t num, uint32_t rot)
+{
+    return (num >> rot) | (num << (32 - rot));
+}
+
+static uint64_t blake2b_rot(uint64_t num, uint32_t rot)
+{
+    return (num >> rot) | (num << (64 - rot));
+}
+
+/*
+ * the mixing function on one column or diagonal of the work vector
+ */
+#define BLAKE2S_G(v, a, b, c, d, x, y) \
+    do { \
+        v[a] = v[a] + v[b] + (x); \
+        v[d] = blake2s_rot(v[d] ^ v[a], 16); \
+        v[c] = v[c] + v[d]; \
+        v[b] = blake2s_rot(v[b] ^ v[c], 12); \
+        v[a] = v[a] + v[b] + (y); \
+        v[d] = blake2s_rot(v[d] ^ v[a], 8); \
+        v[c] = v[c] + v[d]; \
+        v[b] = blake2s_rot(v[b] ^ v[c], 7); \
+    } while (0)
+
+#define BLAKE2B_G(v, a, b, c, d, x, y) \
+    do { \
+        v[a] = v[a] + v[b] + (x); \
+        v[d] = blake2b_rot(v[d] ^ v[a], 32); \
+        v[c] = v[c] + v[d]; \
+        v[b] = blake2b_rot(v[b] ^ v[c], 24); \
+        v[a] = v[a] + v[b] + (y); \
+        v[d] = blake2b_rot(v[d] ^ v[a], 16); \
+        v[c] = v[c] + v[d]; \
+        v[b] = blake2b_rot(v[b] ^ v[c], 63); \
+    } while (0)
+
+/*
+ * compress the data block into the state
+ * the last block is compressed with final set
+ */
+static void blake2s_calculate(t_blake2s *b2s, int final)
+{
+    const uint8_t *s;
+    uint32_t m[16];
+    uint32_t v[16];
+    int i;
+
+    // message words are little-endian
+    for (i = 0; i < 16; i++)
+        m[i] = (uint32_t)b2s->data[i * 4]
+            | ((uint32_t)b2s->data[i * 4 + 1] << 8)
+            | ((uint32_t)b2s->data[i * 4 + 2] << 16)
+            | ((uint32_t)b2s->data[i * 4 + 3] << 24);
+    for (i = 0; i < 8; i++)
+    {
+        v[i] = b2s->hash[i];
+        v[i + 8] = blake2s_iv[i];
+    }
+    v[12] ^= (uint32_t)b2s->counter;
+    v[13] ^= (uint32_t)(b2s->counter >> 32);
+    if (final)
+        v[14] = ~v[14];
+    for (i = 0; i < 10; i++)
+    {
+        s = blake2_sigma[i];
+        BLAKE2S_G(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+        BLAKE2S_G(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+        BLAKE2S_G(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+        BLAKE2S_G(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+        BLAKE2S_G(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+        BLAKE2S_G(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+        BLAKE2S_G(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+        BLAKE2S_G(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+    for (i = 0; i < 8; i++)
+        b2s->hash[i] ^= v[i] ^ v[i + 8];
+    b2s->bytes = 0;
+}
+
+static void blake2b_calculate(t_blake2b *b2b, int final)
+{
+    const uint8_t *s;
+    uint64_t m[16];
+    uint64_t v[16];
+    int i;
+    int j;
+
+    for (i = 0; i < 16; i++)
+    {
+        m[i] = 0;
+        for (j = 7; j >= 0; j--)
+            m[i] = (m[i] << 8) | b2b->data[i * 8 + j];
+    }
+    for (i = 0; i < 8; i++)
+    {
+        v[i] = b2b->hash[i];
+        v[i + 8] = blake2b_iv[i];
+    }
+    // the counter is 128 bits but inputs never reach 2^64 bytes
+    v[12] ^= b2b->counter;
+    if (final)
+        v[14] = ~v[14];
+    for (i = 0; i < 12; i++)
+    {
+        s = blake2_sigma[i];
+        BLAKE2B_G(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+        BLAKE2B_G(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+        BLAKE2B_G(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+        BLAKE2B_G(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+        BLAKE2B_G(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+        BLAKE2B_G(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+        BLAKE2B_G(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+        BLAKE2B_G(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+    for (i = 0; i < 8; i++)
+        b2b->hash[i] ^= v[i] ^ v[i + 8];
+    b2b->bytes = 0;
+}
+
+/*
+ * initialize a blake2 state for an unkeyed full size digest
+ */
+void blake2s_initialize(t_blake2s *b2s)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        b2s->hash[i] = blake2s_iv[i];
+    // parameter block: digest size, no key, fanout and depth of 1
+    b2s->hash[0] ^= 0x01010000 | 32;
+    b2s->bytes = 0;
+    b2s->counter = 0;
+}
+
+void blake2b_initialize(t_blake2b *b2b)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        b2b->hash[i] = blake2b_iv[i];
+    b2b->hash[0] ^= 0x01010000 | 64;
+    b2b->bytes = 0;
+    b2b->counter = 0;
+}
+
+/*
+ * add a buffer of bytes to a blake2 state
+ * the last block has to be compressed as final so a full block is only
+ * compressed once more input arrives
+ */
+void blake2s_add_bytes(t_blake2s *b2s, const uint8_t *bytes, uint64_t len)
+{
+    uint32_t i;
+
+    while (len > 0)
+    {
+        if (b2s->bytes == 64)
+            blake2s_calculate(b2s, 0);
+        i = 64 - b2s->bytes;
+        if (i > len)
+            i = len;
+        len -= i;
+        b2s->counter += i;
+        while (i--)
+            b2s->data[b2s->bytes++] = *bytes++;
+    }
+}
+
+void blake2b_add_bytes(t_blake2b *b2b, const uint8_t *bytes, uint64_t len)
+{
+    uint32_t i;
+
+    while (len > 0)
+    {
+        if (b2b->bytes == 128)
+            blake2b_calculate(b2b, 0);
+        i = 128 - b2b->bytes;
+        if (i > len)
+            i = len;
+        len -= i;
+        b2b->counter += i;
+        while (i--)
+            b2b->data[b2b->bytes++] = *bytes++;
+    }
+}
+
+void blake2s_add_byte(t_blake2s *b2s, uint8_t byte)
+{
+    blake2s_add_bytes(b2s, &byte, 1);
+}
+
+void blake2b_add_byte(t_blake2b *b2b, uint8_t byte)
+{
+    blake2b_add_bytes(b2b, &byte, 1);
+}
+
+/*
+ * add len zero bytes to a blake2 state
+ * the counter is part of every compression so zero blocks can't be skipped
+ */
+void blake2s_add_zeros(t_blake2s *b2s, uint64_t len)
+{
+    static const uint8_t zero[4096];
+
+    for (; len > sizeof(zero); len -= sizeof(zero))
+        blake2s_add_bytes(b2s, zero, sizeof(zero));
+    blake2s_add_bytes(b2s, zero, len);
+}
+
+void blake2b_add_zeros(t_blake2b *b2b, uint64_t len)
+{
+    static const uint8_t zero[4096];
+
+    for (; len > sizeof(zero); len -= sizeof(zero))
+        blake2b_add_bytes(b2b, zero, sizeof(zero));
+    blake2b_add_bytes(b2b, zero, len);
+}
+
+/*
+ * zero pad and compress the last block
+ * after calling this function bytes can no longer be added to it
+ */
+void blake2s_finalize(t_blake2s *b2s)
+{
+    uint32_t i;
+
+    for (i = b2s->bytes; i < 64; i++)
+        b2s->data[i] = 0;
+    blake2s_calculate(b2s, 1);
+}
+
+void blake2b_finalize(t_blake2b *b2b)
+{
+    uint32_t i;
+
+    for (i = b2b->bytes; i < 128; i++)
+        b2b->data[i] = 0;
+    blake2b_calculate(b2b, 1);
+}
+
+/*
+ * copy the digest to a byte array, the state words are little-endian
+ * dst must have at least 32 bytes for blake2s and 64 bytes for blake2b
+ */
+void blake2s_digest(t_blake2s *b2s, uint8_t *dst)
+{
+    int i;
+
+    for (i = 0; i < 32; i++)
+        dst[i] = (b2s->hash[i / 4] >> (8 * (i % 4))) & 0xff;
+}
+
+void blake2b_digest(t_blake2b *b2b, uint8_t *dst)
+{
+    int i;
+
+    for (i = 0; i < 64; i++)
+        dst[i] = (b2b->hash[i / 8] >> (8 * (i % 8))) & 0xff;
+}
@@ -0,0 +1,35 @@
+#ifndef BLAKE2_H
+#define BLAKE2_H
+
+#include <stdint.h>
+
+typedef struct s_blake2s
+{
+    uint8_t data[64];
+    uint32_t hash[8];
+    uint32_t bytes;
+    uint64_t counter;
+} t_blake2s;
+
+typedef struct s_blake2b
+{
+    uint8_t data[128];
+    uint64_t hash[8];
+    uint32_t bytes;
+    uint64_t counter;
+} t_blake2b;
+
+void blake2s_initialize(t_blake2s *b2s);
+void blake2s_add_byte(t_blake2s *b2s, uint8_t byte);
+void blake2s_add_bytes(t_blake2s *b2s, const uint8_t *bytes, uint64_t len);
+void blake2s_add_zeros(t_blake2s *b2s, uint64_t len);
+void blake2s_finalize(t_blake2s *b2s);
+void blake2s_digest(t_blake2s *b2s, uint8_t *dst);
+void blake2b_initialize(t_blake2b *b2b);
+void blake2b_add_byte(t_blake2b *b2b, uint8_t byte);
+void blake2b_add_bytes(t_blake2b *b2b, const uint8_t *bytes, uint64_t len);
+void blake2b_add_zeros(t_blake2b *b2b, uint64_t len);
+void blake2b_finalize(t_blake2b *b2b);
+void blake2b_digest(t_blake2b *b2b, uint8_t *dst);
+
+#endif
@@ -0,0 +1,540 @@
+#include "blake3.h"
+#include "libft.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <sys/stat.h>
+
+/*
+ * x86 cpus with sse2 hash 4 chunks at once, one in each 32bit lane
+ * the choice is made at runtime, define BLAKE3_PORTABLE to always use C
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(BLAKE3_PORTABLE)
+#define BLAKE3_SSE2
+#include <immintrin.h>
+#endif
+
+/*
+ * domain flags of a compression
+ */
+#define BLAKE3_CHUNK_START 1
+#define BLAKE3_CHUNK_END 2
+#define BLAKE3_PARENT 4
+#define BLAKE3_ROOT 8
+
+/*
+ * large files are split into segments that are hashed on separate threads
+ * a segment is a whole subtree of 1024 chunks
+ */
+#define BLAKE3_SEGMENT (1024 * BLAKE3_CHUNK)
+
+static const uint32_t blake3_iv[8] =
+{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+    0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+/*
+ * message word order of every round
+ * each row is the one before it put through the blake3 permutation
+ */
+static const uint8_t blake3_schedule[7][16] =
+{
+    {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+    {2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8},
+    {3, 4, 10, 12, 13, 2, 7, 14, 6, 5, 9, 0, 11, 15, 8, 1},
+    {10, 7, 12, 9, 14, 3, 13, 15, 4, 0, 11, 2, 5, 8, 1, 6},
+    {12, 13, 9, 11, 15, 10, 14, 8, 7, 2, 5, 3, 0, 1, 6, 4},
+    {9, 14, 11, 5, 8, 12, 15, 1, 13, 3, 0, 10, 2, 6, 4, 7},
+    {11, 15, 5, 0, 1, 9, 8, 6, 14, 10, 2, 12, 3, 4, 7, 13}
+};
+
+/*
+ * jobs shared by the workers, each worker takes the next unclaimed segment
+ * errno is per thread so a failed worker stores its errno in error
+ */
+typedef struct s_blake3_pool
+{
+    uint32_t (*cvs)[8];
+    int fd;
+    off_t start;
+    uint64_t count;
+    uint64_t next;
+    int error;
+} t_blake3_pool;
+
+/*
+ * right rotation on a 32bit unsigned int
+ */
+static uint32_t blake3_rot(uint32_t num, uint32_t rot)
+{
+    return (num >> rot) | (num << (32 - rot));
+}
+
+#define BLAKE3_G(v, a, b, c, d, x, y) \
+    do { \
+        v[a] = v[a] + v[b] + (x); \
+        v[d] = blake3_rot(v[d] ^ v[a], 16); \
+        v[c] = v[c] + v[d]; \
+        v[b] = blake3_rot(v[b] ^ v[c], 12); \
+        v[a] = v[a] + v[b] + (y); \
+        v[d] = blake3_rot(v[d] ^ v[a], 8); \
+        v[c] = v[c] + v[d]; \
+        v[b] = blake3_rot(v[b] ^ v[c], 7); \
+    } while (0)
+
+/*
+ * compress one 64 byte block into the chaining value cv
+ * only the first 8 output words are kept, they are the next chaining value
+ * and the 32 byte digest when the block is the root
+ */
+static void blake3_compress(uint32_t *cv, const uint8_t *block, uint32_t len,
+    uint64_t counter, uint32_t flags)
+{
+    const uint8_t *s;
+    uint32_t m[16];
+    uint32_t v[16];
+    int i;
+
+    for (i = 0; i < 16; i++)
+        m[i] = (uint32_t)block[i * 4]
+            | ((uint32_t)block[i * 4 + 1] << 8)
+            | ((uint32_t)block[i * 4 + 2] << 16)
+            | ((uint32_t)block[i * 4 + 3] << 24);
+    for (i = 0; i < 8; i++)
+        v[i] = cv[i];
+    for (i = 0; i < 4; i++)
+        v[i + 8] = blake3_iv[i];
+    v[12] = (uint32_t)counter;
+    v[13] = (uint32_t)(counter >> 32);
+    v[14] = len;
+    v[15] = flags;
+    for (i = 0; i < 7; i++)
+    {
+        s = blake3_schedule[i];
+        BLAKE3_G(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+        BLAKE3_G(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+        BLAKE3_G(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+        BLAKE3_G(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+        BLAKE3_G(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+        BLAKE3_G(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+        BLAKE3_G(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+        BLAKE3_G(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+    }
+    for (i = 0; i < 8; i++)
+        cv[i] = v[i] ^ v[i + 8];
+}
+
+/*
+ * chaining value of a parent node from the chaining values of its children
+ */
+static void blake3_parent(const uint32_t *left, const uint32_t *right,
+    uint32_t *dst, uint32_t flags)
+{
+    uint8_t block[64];
+    int i;
+
+    for (i = 0; i < 32; i++)
+    {
+        block[i] = (left[i / 4] >> (8 * (i % 4))) & 0xff;
+        block[i + 32] = (right[i / 4] >> (8 * (i % 4))) & 0xff;
+    }
+    for (i = 0; i < 8; i++)
+        dst[i] = blake3_iv[i];
+    blake3_compress(dst, block, 64, 0, BLAKE3_PARENT | flags);
+}
+
+/*
+ * chaining value of one whole non-root chunk
+ */
+static void blake3_chunk(const uint8_t *input, uint64_t counter, uint32_t *cv)
+{
+    uint32_t flags;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        cv[i] = blake3_iv[i];
+    for (i = 0; i < 16; i++)
+    {
+        flags = (i == 0) ? BLAKE3_CHUNK_START : (i == 15) ? BLAKE3_CHUNK_END : 0;
+        blake3_compress(cv, input + i * 64, 64, counter, flags);
+    }
+}
+
+#ifdef BLAKE3_SSE2
+
+#define BLAKE3_ROT4(x, n) _mm_or_si128(_mm_srli_epi32(x, n), _mm_slli_epi32(x, 32 - (n)))
+
+#define BLAKE3_G4(v, a, b, c, d, x, y) \
+    do { \
+        v[a] = _mm_add_epi32(_mm_add_epi32(v[a], v[b]), x); \
+        v[d] = BLAKE3_ROT4(_mm_xor_si128(v[d], v[a]), 16); \
+        v[c] = _mm_add_epi32(v[c], v[d]); \
+        v[b] = BLAKE3_ROT4(_mm_xor_si128(v[b], v[c]), 12); \
+        v[a] = _mm_add_epi32(_mm_add_epi32(v[a], v[b]), y); \
+        v[d] = BLAKE3_ROT4(_mm_xor_si128(v[d], v[a]), 8); \
+        v[c] = _mm_add_epi32(v[c], v[d]); \
+        v[b] = BLAKE3_ROT4(_mm_xor_si128(v[b], v[c]), 7); \
+    } while (0)
+
+/*
+ * chaining values of 4 whole chunks that follow each other in input
+ * every vector holds the same state word of the 4 chunks so the rounds
+ * are the scalar ones with each operation done on 4 chunks
+ * message words are transposed from the 4 blocks 4 words at a time
+ */
+__attribute__((target("sse2")))
+static void blake3_chunks4(const uint8_t *input, uint64_t counter, uint32_t (*cvs)[8])
+{
+    __m128i h[8], v[16], m[16], r[4], t[4];
+    __m128i lo, hi;
+    uint32_t out[8][4];
+    const uint8_t *s;
+    int block;
+    int i;
+
+    for (i = 0; i < 8; i++)
+        h[i] = _mm_set1_epi32(blake3_iv[i]);
+    lo = _mm_setr_epi32((uint32_t)counter, (uint32_t)(counter + 1),
+        (uint32_t)(counter + 2), (uint32_t)(counter + 3));
+    hi = _mm_setr_epi32((uint32_t)(counter >> 32), (uint32_t)((counter + 1) >> 32),
+        (uint32_t)((counter + 2) >> 32), (uint32_t)((counter + 3) >> 32));
+    for (block = 0; block < 16; block++)
+    {
+        for (i = 0; i < 16; i += 4)
+        {
+            r[0] = _mm_loadu_si128((const __m128i *)(input + block * 64 + i * 4));
+            r[1] = _mm_loadu_si128((const __m128i *)(input + BLAKE3_CHUNK + block * 64 + i * 4));
+            r[2] = _mm_loadu_si128((const __m128i *)(input + 2 * BLAKE3_CHUNK + block * 64 + i * 4));
+            r[3] = _mm_loadu_si128((const __m128i *)(input + 3 * BLAKE3_CHUNK + block * 64 + i * 4));
+            t[0] = _mm_unpacklo_epi32(r[0], r[1]);
+            t[1] = _mm_unpacklo_epi32(r[2], r[3]);
+            t[2] = _mm_unpackhi_epi32(r[0], r[1]);
+            t[3] = _mm_unpackhi_epi32(r[2], r[3]);
+            m[i] = _mm_unpacklo_epi64(t[0], t[1]);
+            m[i + 1] = _mm_unpackhi_epi64(t[0], t[1]);
+            m[i + 2] = _mm_unpacklo_epi64(t[2], t[3]);
+            m[i + 3] = _mm_unpackhi_epi64(t[2], t[3]);
+        }
+        for (i = 0; i < 8; i++)
+            v[i] = h[i];
+        for (i = 0; i < 4; i++)
+            v[i + 8] = _mm_set1_epi32(blake3_iv[i]);
+        v[12] = lo;
+        v[13] = hi;
+        v[14] = _mm_set1_epi32(64);
+        v[15] = _mm_set1_epi32((block == 0) ? BLAKE3_CHUNK_START
+            : (block == 15) ? BLAKE3_CHUNK_END : 0);
+        for (i = 0; i < 7; i++)
+        {
+            s = blake3_schedule[i];
+            BLAKE3_G4(v, 0, 4, 8, 12, m[s[0]], m[s[1]]);
+            BLAKE3_G4(v, 1, 5, 9, 13, m[s[2]], m[s[3]]);
+            BLAKE3_G4(v, 2, 6, 10, 14, m[s[4]], m[s[5]]);
+            BLAKE3_G4(v, 3, 7, 11, 15, m[s[6]], m[s[7]]);
+            BLAKE3_G4(v, 0, 5, 10, 15, m[s[8]], m[s[9]]);
+            BLAKE3_G4(v, 1, 6, 11, 12, m[s[10]], m[s[11]]);
+            BLAKE3_G4(v, 2, 7, 8, 13, m[s[12]], m[s[13]]);
+            BLAKE3_G4(v, 3, 4, 9, 14, m[s[14]], m[s[15]]);
+        }
+        for (i = 0; i < 8; i++)
+            h[i] = _mm_xor_si128(v[i], v[i + 8]);
+    }
+    for (i = 0; i < 8; i++)
+        _mm_storeu_si128((__m128i *)out[i], h[i]);
+    for (i = 0; i < 32; i++)
+        cvs[i % 4][i / 4] = out[i / 4][i % 4];
+}
+
+#endif
+
+/*
+ * chaining values of count whole chunks that follow each other in input
+ */
+static void blake3_chunks(const uint8_t *input, uint64_t count, uint64_t counter,
+    uint32_t (*cvs)[8])
+{
+    uint64_t i;
+
+    i = 0;
+#ifdef BLAKE3_SSE2
+    if (__builtin_cpu_supports("sse2"))
+        for (; i + 4 <= count; i += 4)
+            blake3_chunks4(input + i * BLAKE3_CHUNK, counter + i, cvs + i);
+#endif
+    for (; i < count; i++)
+        blake3_chunk(input + i * BLAKE3_CHUNK, counter + i, cvs[i]);
+}
+
+/*
+ * merge the finished subtrees on the stack
+ * every set bit of the number of chunks before b3->chunk is a subtree
+ * that stays, the top value is never merged before the next chunk starts
+ * because it might end up as the root
+ */
+static void blake3_merge(t_blake3 *b3)
+{
+    uint64_t chunks;
+    uint32_t keep;
+
+    keep = 0;
+    for (chunks = b3->chunk; chunks != 0; chunks &= chunks - 1)
+        keep++;
+    while (b3->depth > keep)
+    {
+        blake3_parent(b3->stack[b3->depth - 2], b3->stack[b3->depth - 1],
+            b3->stack[b3->depth - 2], 0);
+        b3->depth--;
+    }
+}
+
+/*
+ * add the chaining value of chunk b3->chunk to the stack
+ */
+static void blake3_push(t_blake3 *b3, const uint32_t *cv)
+{
+    int i;
+
+    blake3_merge(b3);
+    for (i = 0; i < 8; i++)
+        b3->stack[b3->depth][i] = cv[i];
+    b3->depth++;
+}
+
+/*
+ * start the next chunk with a fresh chaining value
+ */
+static void blake3_next_chunk(t_blake3 *b3)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        b3->cv[i] = blake3_iv[i];
+    b3->bytes = 0;
+    b3->blocks = 0;
+}
+
+void blake3_initialize(t_blake3 *b3)
+{
+    blake3_next_chunk(b3);
+    b3->chunk = 0;
+    b3->depth = 0;
+}
+
+/*
+ * add a buffer of bytes to a blake3 state
+ * the last block and the last chunk decide the root so they are only
+ * compressed once more input arrives
+ * whole chunks in the input are hashed in place without copying them
+ */
+void blake3_add_bytes(t_blake3 *b3, const uint8_t *bytes, uint64_t len)
+{
+    uint32_t cvs[16][8];
+    uint64_t count;
+    uint64_t i;
+    uint32_t n;
+
+    while (len > 0)
+    {
+        if (b3->bytes == 64)
+        {
+            b3->blocks++;
+            blake3_compress(b3->cv, b3->data, 64, b3->chunk,
+                (b3->blocks == 1) ? BLAKE3_CHUNK_START
+                : (b3->blocks == 16) ? BLAKE3_CHUNK_END : 0);
+            b3->bytes = 0;
+            if (b3->blocks == 16)
+            {
+                blake3_push(b3, b3->cv);
+                b3->chunk++;
+                blake3_next_chunk(b3);
+            }
+        }
+        // at least one byte is kept back for the last chunk
+        if (b3->bytes == 0 && b3->blocks == 0 && len > BLAKE3_CHUNK)
+        {
+            count = (len - 1) / BLAKE3_CHUNK;
+            if (count > 16)
+                count = 16;
+            blake3_chunks(bytes, count, b3->chunk, cvs);
+            for (i = 0; i < count; i++)
+            {
+                blake3_push(b3, cvs[i]);
+                b3->chunk++;
+            }
+            bytes += count * BLAKE3_CHUNK;
+            len -= count * BLAKE3_CHUNK;
+            continue;
+        }
+        n = 64 - b3->bytes;
+        if (n > len)
+            n = len;
+        len -= n;
+        while (n--)
+            b3->data[b3->bytes++] = *bytes++;
+    }
+}
+
+void blake3_add_byte(t_blake3 *b3, uint8_t byte)
+{
+    blake3_add_bytes(b3, &byte, 1);
+}
+
+/*
+ * add len zero bytes to a blake3 state
+ * the chunk counter is part of every compression so zeros can't be skipped
+ */
+void blake3_add_zeros(t_blake3 *b3, uint64_t len)
+{
+    static const uint8_t zero[16 * BLAKE3_CHUNK];
+
+    for (; len > sizeof(zero); len -= sizeof(zero))
+        blake3_add_bytes(b3, zero, sizeof(zero));
+    blake3_add_bytes(b3, zero, len);
+}
+
+/*
+ * read a whole segment with pread and reduce it to one chaining value
+ * the chunk chaining values are merged pairwise up to the subtree root
+ * returns 0 or the errno of the failed read
+ */
+static int blake3_segment(t_blake3_pool *pool, uint8_t *buffer, uint64_t index)
+{
+    uint32_t cvs[BLAKE3_SEGMENT / BLAKE3_CHUNK][8];
+    uint64_t count;
+    uint64_t done;
+    uint64_t i;
+    ssize_t len;
+
+    done = 0;
+    while (done < BLAKE3_SEGMENT)
+    {
+        len = pread(pool->fd, buffer + done, BLAKE3_SEGMENT - done,
+            pool->start + index * BLAKE3_SEGMENT + done);
+        if (len < 0)
+            return errno;
+        // the file got shorter since its size was read
+        if (len == 0)
+            return ENODATA;
+        done += len;
+    }
+    count = BLAKE3_SEGMENT / BLAKE3_CHUNK;
+    blake3_chunks(buffer, count, index * count, cvs);
+    for (; count > 1; count /= 2)
+        for (i = 0; i < count / 2; i++)
+            blake3_parent(cvs[i * 2], cvs[i * 2 + 1], cvs[i], 0);
+    for (i = 0; i < 8; i++)
+        pool->cvs[index][i] = cvs[0][i];
+    return 0;
+}
+
+static void *blake3_worker(void *data)
+{
+    t_blake3_pool *pool;
+    uint8_t *buffer;
+    uint64_t i;
+    int error;
+
+    pool = data;
+    buffer = malloc(BLAKE3_SEGMENT);
+    if (buffer == NULL)
+    {
+        __atomic_store_n(&pool->error, ENOMEM, __ATOMIC_RELAXED);
+        return NULL;
+    }
+    i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    while (i < pool->count && __atomic_load_n(&pool->error, __ATOMIC_RELAXED) == 0)
+    {
+        error = blake3_segment(pool, buffer, i);
+        if (error != 0)
+            __atomic_store_n(&pool->error, error, __ATOMIC_RELAXED);
+        i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    }
+    free(buffer);
+    return NULL;
+}
+
+/*
+ * hash the whole segments of a large regular file on one thread per cpu
+ * the state has to be fresh, fd is left after the last segment so the
+ * caller reads the rest which always includes the root chunk
+ * returns 0 with errno set on read errors
+ * files that don't qualify are left untouched and so are sparse files
+ * which hash_fd reads extent by extent
+ */
+int blake3_add_fd(t_blake3 *b3, int fd)
+{
+    t_blake3_pool pool;
+    struct stat st;
+    uint64_t i;
+
+    if (b3->chunk != 0 || b3->blocks != 0 || b3->bytes != 0
+        || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)
+        || st.st_blocks * 512 < st.st_size)
+        return 1;
+    pool.start = lseek(fd, 0, SEEK_CUR);
+    if (pool.start == -1 || st.st_size <= pool.start)
+        return 1;
+    pool.count = (st.st_size - pool.start - 1) / BLAKE3_SEGMENT;
+    // a single thread is no faster than reading the file normally
+    if (pool.count < 2 || sysconf(_SC_NPROCESSORS_ONLN) < 2)
+        return 1;
+    pool.cvs = malloc(sizeof(*pool.cvs) * pool.count);
+    if (pool.cvs == NULL)
+        return 1;
+    pool.fd = fd;
+    pool.next = 0;
+    pool.error = 0;
+    ft_parallel(blake3_worker, &pool, pool.count);
+    // segments are whole subtrees so they go on the stack like chunks
+    for (i = 0; pool.error == 0 && i < pool.count; i++)
+    {
+        b3->chunk = i * (BLAKE3_SEGMENT / BLAKE3_CHUNK);
+        blake3_push(b3, pool.cvs[i]);
+    }
+    b3->chunk = pool.count * (BLAKE3_SEGMENT / BLAKE3_CHUNK);
+    free(pool.cvs);
+    if (pool.error != 0)
+    {
+        errno = pool.error;
+        return 0;
+    }
+    return lseek(fd, pool.start + pool.count * BLAKE3_SEGMENT, SEEK_SET) != -1;
+}
+
+/*
+ * compress the last block of the last chunk and merge the stack into the root
+ * after calling this function bytes can no longer be added to it
+ */
+void blake3_finalize(t_blake3 *b3)
+{
+    uint32_t flags;
+    uint32_t i;
+
+    blake3_merge(b3);
+    for (i = b3->bytes; i < 64; i++)
+        b3->data[i] = 0;
+    flags = BLAKE3_CHUNK_END | ((b3->blocks == 0) ? BLAKE3_CHUNK_START : 0);
+    for (i = 0; i < 8; i++)
+        b3->hash[i] = b3->cv[i];
+    blake3_compress(b3->hash, b3->data, b3->bytes, b3->chunk,
+        flags | ((b3->depth == 0) ? BLAKE3_ROOT : 0));
+    // the last chunk is the right edge of the tree, merge it up to the root
+    while (b3->depth > 0)
+    {
+        b3->depth--;
+        blake3_parent(b3->stack[b3->depth], b3->hash, b3->hash,
+            (b3->depth == 0) ? BLAKE3_ROOT : 0);
+    }
+}
+
+/*
+ * copy the 32 byte digest to a byte array, the words are little-endian
+ */
+void blake3_digest(t_blake3 *b3, uint8_t *dst)
+{
+    int i;
+
+    for (i = 0; i < 32; i++)
+        dst[i] = (b3->hash[i / 4] >> (8 * (i % 4))) & 0xff;
+}
@@ -0,0 +1,33 @@
+#ifndef BLAKE3_H
+#define BLAKE3_H
+
+#include <stdint.h>
+
+/*
+ * inputs are split into 1024 byte chunks that are the leaves of a binary tree
+ * 54 chaining values are enough for 2^64 bytes
+ */
+#define BLAKE3_CHUNK 1024
+#define BLAKE3_STACK 54
+
+typedef struct s_blake3
+{
+    uint8_t data[64];
+    uint32_t cv[8];
+    uint32_t bytes;
+    uint32_t blocks;
+    uint64_t chunk;
+    uint32_t stack[BLAKE3_STACK][8];
+    uint32_t depth;
+    uint32_t hash[8];
+} t_blake3;
+
+void blake3_initialize(t_blake3 *b3);
+void blake3_add_byte(t_blake3 *b3, uint8_t byte);
+void blake3_add_bytes(t_blake3 *b3, const uint8_t *bytes, uint64_t len);
+void blake3_add_zeros(t_blake3 *b3, uint64_t len);
+int blake3_add_fd(t_blake3 *b3, int fd);
+void blake3_finalize(t_blake3 *b3);
+void blake3_digest(t_blake3 *b3, uint8_t *dst);
+
+#endif
@@ -0,0 +1,358 @@
+#include "ft_ssl.h"
+#include "libft.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+/*
+ * content defined chunk sizes
+ * boundaries are never closer than CHUNK_MIN and never further than CHUNK_MAX
+ */
+#define CHUNK_MIN 2048
+#define CHUNK_AVG 8192
+#define CHUNK_MAX 65536
+
+/*
+ * input is scanned in batches, the chunks of one batch are hashed by the
+ * workers while the next batch is read and scanned
+ */
+#define CHUNK_BATCH 4194304
+#define CHUNK_SPANS ((CHUNK_BATCH + CHUNK_MAX) / CHUNK_MIN + 1)
+
+/*
+ * FastCDC normalized chunking masks
+ * the stricter mask (15 bits) is used before CHUNK_AVG and the looser
+ * one (11 bits) after it which pulls chunk sizes towards the average
+ */
+#define CHUNK_MASK_S 0x0000d9f003530000ULL
+#define CHUNK_MASK_L 0x0000d90003530000ULL
+
+typedef struct s_chunker
+{
+    uint64_t fp;
+    uint64_t size;
+    uint64_t offset;
+} t_chunker;
+
+/*
+ * one chunk of a batch and its digest once a worker has hashed it
+ */
+typedef struct s_chunk_span
+{
+    uint64_t start;
+    uint64_t size;
+    t_sha256 sha;
+} t_chunk_span;
+
+/*
+ * a batch holds whole chunks only, the unfinished chunk at the end is
+ * carried to the start of the next batch
+ */
+typedef struct s_chunk_batch
+{
+    uint8_t data[CHUNK_BATCH + CHUNK_MAX];
+    uint64_t size;
+    uint64_t offset;
+    t_chunk_span spans[CHUNK_SPANS];
+    int count;
+} t_chunk_batch;
+
+/*
+ * batch handed to the workers, next is the first unclaimed span and done
+ * counts hashed spans, batch goes back to NULL when all are done
+ */
+typedef struct s_chunk_pool
+{
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t idle;
+    t_chunk_batch *batch;
+    int next;
+    int done;
+    int quit;
+} t_chunk_pool;
+
+/*
+ * gear table of random 64bit values, one per byte value
+ * filled from a fixed seed so boundaries are the same on every run
+ */
+static uint64_t g_gear[256];
+
+static void chunk_gear_init(void)
+{
+    uint64_t seed;
+    uint64_t z;
+    int i;
+
+    if (g_gear[0] != 0)
+        return;
+    // splitmix64
+    seed = 0x2545f4914f6cdd1dULL;
+    for (i = 0; i < 256; i++)
+    {
+        seed += 0x9e3779b97f4a7c15ULL;
+        z = seed;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        g_gear[i] = z ^ (z >> 31);
+    }
+}
+
+/*
+ * scan for the end of the current chunk
+ * returns how many bytes of the buffer belong to the current chunk
+ * *found is set when the chunk ends inside the buffer
+ */
+static uint64_t chunk_scan(t_chunker *chunk, const uint8_t *buffer,
+    uint64_t len, int *found)
+{
+    uint64_t fp;
+    uint64_t i;
+
+    *found = 0;
+    i = 0;
+    // no boundary can be before the minimum size so skip without hashing
+    if (chunk->size < CHUNK_MIN)
+    {
+        i = CHUNK_MIN - chunk->size;
+        if (i > len)
+            i = len;
+        chunk->size += i;
+    }
+    fp = chunk->fp;
+    for (; i < len; i++)
+    {
+        fp = (fp << 1) + g_gear[buffer[i]];
+        chunk->size++;
+        if ((chunk->size <= CHUNK_AVG && !(fp & CHUNK_MASK_S))
+            || (chunk->size > CHUNK_AVG && !(fp & CHUNK_MASK_L))
+            || chunk->size == CHUNK_MAX)
+        {
+            *found = 1;
+            i++;
+            break;
+        }
+    }
+    chunk->fp = fp;
+    return i;
+}
+
+/*
+ * print the digest of a hashed chunk
+ */
+static void chunk_print(t_args *args, t_chunk_span *span, uint64_t offset, char *name)
+{
+    char digest[FT_DIGEST_MAX * 2 + 1];
+    char start[21];
+    char length[21];
+    char label[44];
+
+    args->sha = span->sha;
+    ft_utoa(offset + span->start, start);
+    ft_utoa(span->size, length);
+    ft_strcat(ft_strcat(ft_strcpy(label, start), "+"), length);
+    if (hash_skip(args) || print_binary_at(args, name, label))
+        return;
+    hash_string(args, digest);
+    if (!(args->flags & (FT_REVERSE | FT_QUIET)))
+        ft_putstr(8, args->HASH, " (", name, " @ ", label, ") = ", digest, "\n");
+    else if (args->flags & FT_REVERSE && !(args->flags & FT_QUIET))
+        ft_putstr(8, digest, " ", start, " ", length, " ", name, "\n");
+    else
+        ft_putstr(6, start, " ", length, " ", digest, "\n");
+}
+
+static void chunk_hash(t_chunk_batch *batch, int i)
+{
+    t_chunk_span *span;
+
+    span = &batch->spans[i];
+    sha256_initialize(&span->sha);
+    sha256_add_bytes(&span->sha, batch->data + span->start, span->size);
+    sha256_finalize(&span->sha);
+}
+
+/*
+ * hash spans of the current batch until told to quit
+ */
+static void *chunk_worker(void *data)
+{
+    t_chunk_pool *pool;
+    t_chunk_batch *batch;
+    int i;
+
+    pool = data;
+    pthread_mutex_lock(&pool->lock);
+    while (1)
+    {
+        while (!pool->quit && (pool->batch == NULL || pool->next == pool->batch->count))
+            pthread_cond_wait(&pool->work, &pool->lock);
+        if (pool->quit)
+            break;
+        batch = pool->batch;
+        i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        chunk_hash(batch, i);
+        pthread_mutex_lock(&pool->lock);
+        if (++pool->done == batch->count)
+        {
+            pool->batch = NULL;
+            pthread_cond_signal(&pool->idle);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/*
+ * wait for the workers to finish the batch they have
+ */
+static void chunk_wait(t_chunk_pool *pool)
+{
+    pthread_mutex_lock(&pool->lock);
+    while (pool->batch != NULL)
+        pthread_cond_wait(&pool->idle, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * give a scanned batch to the workers
+ * without workers the batch is hashed right away
+ */
+static void chunk_start(t_chunk_pool *pool, t_chunk_batch *batch, int workers)
+{
+    int i;
+
+    if (batch->count == 0)
+        return;
+    if (workers == 0)
+    {
+        for (i = 0; i < batch->count; i++)
+            chunk_hash(batch, i);
+        return;
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->batch = batch;
+    pool->next = 0;
+    pool->done = 0;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+/*
+ * fill a batch with the carried bytes of the last one and new input
+ * then split it at every chunk boundary
+ * returns the number of bytes read, 0 at the end of input and -1 on error
+ */
+static ssize_t chunk_fill(t_chunker *chunk, t_chunk_batch *batch,
+    t_chunk_batch *last, int fd)
+{
+    uint64_t start;
+    uint64_t pos;
+    ssize_t total;
+    ssize_t len;
+    int found;
+
+    batch->offset = chunk->offset;
+    batch->count = 0;
+    if (last != NULL)
+        memcpy(batch->data, last->data + last->size - chunk->size, chunk->size);
+    batch->size = chunk->size;
+    pos = batch->size;
+    total = 0;
+    len = 1;
+    while (batch->size < CHUNK_BATCH && len > 0)
+    {
+        len = read(fd, batch->data + batch->size, CHUNK_BATCH - batch->size);
+        if (len < 0)
+            return -1;
+        batch->size += len;
+        total += len;
+    }
+    start = 0;
+    while (pos < batch->size)
+    {
+        pos += chunk_scan(chunk, batch->data + pos, batch->size - pos, &found);
+        if (!found)
+            break;
+        batch->spans[batch->count].start = start;
+        batch->spans[batch->count++].size = pos - start;
+        chunk->offset += pos - start;
+        chunk->size = 0;
+        chunk->fp = 0;
+        start = pos;
+    }
+    // the last chunk ends at the end of the input
+    if (total == 0 && start < batch->size)
+    {
+        batch->spans[batch->count].start = start;
+        batch->spans[batch->count++].size = batch->size - start;
+    }
+    return total;
+}
+
+/*
+ * split the input into content defined chunks and print a sha256 per chunk
+ * one thread scans for boundaries while the others hash the chunks found
+ * in the batch before, digests are printed in input order
+ */
+int process_chunks(t_args *args, int fd, char *name)
+{
+    pthread_t threads[64];
+    t_chunk_batch *batches;
+    t_chunk_pool pool;
+    t_chunker chunk;
+    ssize_t len;
+    long cpus;
+    int workers;
+    int cur;
+    int i;
+
+    batches = malloc(sizeof(t_chunk_batch) * 2);
+    if (batches == NULL)
+        return 0;
+    chunk_gear_init();
+    chunk.fp = 0;
+    chunk.size = 0;
+    chunk.offset = 0;
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.work, NULL);
+    pthread_cond_init(&pool.idle, NULL);
+    pool.batch = NULL;
+    pool.quit = 0;
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    workers = (cpus < 1) ? 1 : (cpus > 64) ? 64 : cpus;
+    // with no workers the scanning thread hashes each batch itself
+    for (i = 0; i < workers; i++)
+        if (pthread_create(&threads[i], NULL, chunk_worker, &pool) != 0)
+            break;
+    workers = i;
+    cur = 0;
+    len = chunk_fill(&chunk, &batches[cur], NULL, fd);
+    while (len >= 0)
+    {
+        chunk_start(&pool, &batches[cur], workers);
+        if (len == 0)
+            break;
+        len = chunk_fill(&chunk, &batches[!cur], &batches[cur], fd);
+        chunk_wait(&pool);
+        for (i = 0; i < batches[cur].count; i++)
+            chunk_print(args, &batches[cur].spans[i], batches[cur].offset, name);
+        cur = !cur;
+    }
+    chunk_wait(&pool);
+    for (i = 0; len == 0 && i < batches[cur].count; i++)
+        chunk_print(args, &batches[cur].spans[i], batches[cur].offset, name);
+    pthread_mutex_lock(&pool.lock);
+    pool.quit = 1;
+    pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+    for (i = 0; i < workers; i++)
+        pthread_join(threads[i], NULL);
+    pthread_mutex_destroy(&pool.lock);
+    pthread_cond_destroy(&pool.work);
+    pthread_cond_destroy(&pool.idle);
+    free(batches);
+    return len == 0;
+}
@@ -0,0 +1,199 @@
+// O_DIRECT and MAP_HUGETLB are linux extensions
+#define _GNU_SOURCE
+
+#include "ft_ssl.h"
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <linux/aio_abi.h>
+#include <sys/mman.h>
+
+/*
+ * size of one read request and how many requests are kept in flight
+ * both are multiples of any logical block size O_DIRECT may require
+ */
+#define DIRECT_BLOCK 1048576
+#define DIRECT_DEPTH 4
+
+/*
+ * map the read buffers, preferring explicit huge pages
+ * mmap always returns page aligned memory which satisfies O_DIRECT
+ */
+static uint8_t *direct_alloc(size_t size)
+{
+    void *pool;
+
+    pool = mmap(NULL, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (pool != MAP_FAILED)
+        return pool;
+    pool = mmap(NULL, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pool == MAP_FAILED)
+        return NULL;
+    madvise(pool, size, MADV_HUGEPAGE);
+    return pool;
+}
+
+/*
+ * plain reads for files that can't use O_DIRECT
+ * pages are dropped from the cache behind the reader so a large scan
+ * still doesn't push out everything else
+ */
+static int direct_buffered(t_args *args, int fd, off_t offset, uint8_t *buffer)
+{
+    ssize_t len;
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_DIRECT);
+    posix_fadvise(fd, offset, 0, POSIX_FADV_SEQUENTIAL);
+    len = pread(fd, buffer, DIRECT_BLOCK, offset);
+    while (len > 0)
+    {
+        hash_add_bytes(args, buffer, len);
+        posix_fadvise(fd, offset, len, POSIX_FADV_DONTNEED);
+        offset += len;
+        len = pread(fd, buffer, DIRECT_BLOCK, offset);
+    }
+    return len == 0;
+}
+
+/*
+ * kernel aio on an O_DIRECT fd reads straight into the buffers and keeps
+ * every queued request in flight at once, the queue is DIRECT_DEPTH deep
+ * completions can arrive in any order so each slot keeps its own result
+ */
+typedef struct s_direct_queue
+{
+    aio_context_t ctx;
+    struct iocb cb[DIRECT_DEPTH];
+    ssize_t result[DIRECT_DEPTH];
+    int pending[DIRECT_DEPTH];
+} t_direct_queue;
+
+/*
+ * queue a read of slot i at offset
+ * returns 0 when the kernel refused the request
+ */
+static int direct_submit(t_direct_queue *queue, int i, off_t offset)
+{
+    struct iocb *list[1];
+
+    queue->cb[i].aio_offset = offset;
+    list[0] = &queue->cb[i];
+    if (syscall(SYS_io_submit, queue->ctx, 1, list) != 1)
+        return 0;
+    queue->pending[i] = 1;
+    return 1;
+}
+
+/*
+ * wait for slot i and return its result like pread would
+ * errors are returned as -errno
+ */
+static ssize_t direct_wait(t_direct_queue *queue, int i)
+{
+    struct io_event event;
+    long ret;
+
+    while (queue->pending[i])
+    {
+        ret = syscall(SYS_io_getevents, queue->ctx, 1, 1, &event, NULL);
+        if (ret == 1)
+        {
+            queue->result[event.data] = event.res;
+            queue->pending[event.data] = 0;
+        }
+        else if (errno != EINTR)
+            return -errno;
+    }
+    return queue->result[i];
+}
+
+/*
+ * hash fd from its current offset with O_DIRECT reads
+ * DIRECT_DEPTH requests are queued ahead of the one being hashed
+ * falls back to plain reads from the first byte not hashed yet when fd,
+ * the filesystem or the kernel doesn't allow direct reads
+ */
+int hash_direct(t_args *args, int fd)
+{
+    t_direct_queue queue;
+    uint8_t *pool;
+    off_t offset;
+    ssize_t len;
+    int done;
+    int ret;
+    int i;
+
+    pool = direct_alloc(DIRECT_BLOCK * DIRECT_DEPTH);
+    if (pool == NULL)
+        return 0;
+    offset = lseek(fd, 0, SEEK_CUR);
+    if (offset == -1)
+        offset = 0;
+    queue.ctx = 0;
+    if (!(fcntl(fd, F_GETFL) & O_DIRECT) || offset % 4096 != 0
+        || syscall(SYS_io_setup, DIRECT_DEPTH, &queue.ctx) != 0)
+    {
+        ret = direct_buffered(args, fd, offset, pool);
+        munmap(pool, DIRECT_BLOCK * DIRECT_DEPTH);
+        return ret;
+    }
+    ret = 1;
+    for (i = 0; i < DIRECT_DEPTH; i++)
+    {
+        queue.cb[i] = (struct iocb){0};
+        queue.cb[i].aio_data = i;
+        queue.cb[i].aio_lio_opcode = IOCB_CMD_PREAD;
+        queue.cb[i].aio_fildes = fd;
+        queue.cb[i].aio_buf = (uint64_t)(uintptr_t)(pool + (size_t)i * DIRECT_BLOCK);
+        queue.cb[i].aio_nbytes = DIRECT_BLOCK;
+        queue.pending[i] = 0;
+        if (ret == 1 && !direct_submit(&queue, i, offset + (off_t)i * DIRECT_BLOCK))
+            ret = -1;
+    }
+    done = (ret == -1);
+    i = 0;
+    while (!done)
+    {
+        len = direct_wait(&queue, i);
+        // the filesystem rejected the direct read, redo it and the rest
+        if (len == -EINVAL)
+        {
+            done = 1;
+            ret = -1;
+        }
+        else if (len < 0)
+        {
+            errno = -len;
+            done = 1;
+            ret = 0;
+        }
+        else
+        {
+            hash_add_bytes(args, pool + (size_t)i * DIRECT_BLOCK, len);
+            offset += len;
+            // a short read is the unaligned tail at the end of the file
+            if (len < DIRECT_BLOCK)
+                done = 1;
+            // a request the kernel won't queue is read normally instead
+            else if (!direct_submit(&queue, i,
+                queue.cb[i].aio_offset + (off_t)DIRECT_BLOCK * DIRECT_DEPTH))
+            {
+                done = 1;
+                ret = -1;
+            }
+        }
+        i = (i + 1) % DIRECT_DEPTH;
+    }
+    // every request must finish before its buffer goes away
+    for (i = 0; i < DIRECT_DEPTH; i++)
+        direct_wait(&queue, i);
+    syscall(SYS_io_destroy, queue.ctx);
+    if (ret == -1)
+        ret = direct_buffered(args, fd, offset, pool);
+    munmap(pool, DIRECT_BLOCK * DIRECT_DEPTH);
+    return ret;
+}
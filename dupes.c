@@ -0,0 +1,350 @@
+#include "ft_ssl.h"
+#include "libft.h"
+#include "dynar.h"
+#include "encode.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/*
+ * bytes hashed from each end of a file for the partial hash
+ * files up to twice this size are hashed completely in the partial pass
+ */
+#define DUPES_EDGE 4096
+
+typedef struct s_dupe
+{
+    char *path;
+    uint64_t size;
+    dev_t dev;
+    ino_t ino;
+    size_t order;
+    int valid;
+    uint8_t partial[32];
+    uint8_t full[32];
+} t_dupe;
+
+/*
+ * order by size, then partial digest, then full digest, then the order
+ * files were found in
+ * digests that haven't been computed yet are all zero so compare equal
+ */
+static int dupes_compare(const void *a, const void *b)
+{
+    const t_dupe *x;
+    const t_dupe *y;
+    int ret;
+
+    x = a;
+    y = b;
+    if (x->size != y->size)
+        return (x->size < y->size) ? -1 : 1;
+    if (x->valid != y->valid)
+        return x->valid - y->valid;
+    ret = memcmp(x->partial, y->partial, sizeof(x->partial));
+    if (ret != 0)
+        return ret;
+    ret = memcmp(x->full, y->full, sizeof(x->full));
+    if (ret != 0)
+        return ret;
+    // qsort isn't stable so the order files were found in keeps groups in order
+    return (x->order < y->order) ? -1 : (x->order > y->order);
+}
+
+/*
+ * order by inode and then by the order files were found in
+ */
+static int dupes_compare_inode(const void *a, const void *b)
+{
+    const t_dupe *x;
+    const t_dupe *y;
+
+    x = a;
+    y = b;
+    if (x->dev != y->dev)
+        return (x->dev < y->dev) ? -1 : 1;
+    if (x->ino != y->ino)
+        return (x->ino < y->ino) ? -1 : 1;
+    return (x->order < y->order) ? -1 : (x->order > y->order);
+}
+
+/*
+ * keep only the first path of every file
+ * a file named twice, found under overlapping directories or hard linked
+ * is one copy and must never be reported as a duplicate of itself
+ * returns the new number of files
+ */
+static size_t dupes_unique(t_dupe *list, size_t count)
+{
+    size_t kept;
+    size_t i;
+
+    if (count == 0)
+        return 0;
+    qsort(list, count, sizeof(t_dupe), dupes_compare_inode);
+    kept = 1;
+    for (i = 1; i < count; i++)
+    {
+        if (list[i].dev == list[kept - 1].dev && list[i].ino == list[kept - 1].ino)
+            free(list[i].path);
+        else
+            list[kept++] = list[i];
+    }
+    return kept;
+}
+
+/*
+ * add a regular file or every regular file below a directory
+ * symlinks are skipped so nothing is visited twice
+ */
+static int dupes_collect(t_args *args, t_dynar *list, char *path)
+{
+    struct dirent *entry;
+    struct stat st;
+    t_dupe dupe;
+    char *child;
+    DIR *dir;
+
+    if (lstat(path, &st) == -1)
+    {
+        error_msg(args->hash, path, NULL);
+        return 1;
+    }
+    if (S_ISREG(st.st_mode))
+    {
+        memset(&dupe, 0, sizeof(dupe));
+        dupe.path = malloc(ft_strlen(path) + 1);
+        if (dupe.path == NULL)
+            return 0;
+        ft_strcpy(dupe.path, path);
+        dupe.size = st.st_size;
+        dupe.dev = st.st_dev;
+        dupe.ino = st.st_ino;
+        dupe.order = list->size / sizeof(t_dupe);
+        dupe.valid = 1;
+        return dynar_append(list, (char *)&dupe, sizeof(dupe));
+    }
+    if (!S_ISDIR(st.st_mode))
+        return 1;
+    dir = opendir(path);
+    if (dir == NULL)
+    {
+        error_msg(args->hash, path, NULL);
+        return 1;
+    }
+    entry = readdir(dir);
+    while (entry != NULL)
+    {
+        if (ft_strcmp(entry->d_name, ".") != 0 && ft_strcmp(entry->d_name, "..") != 0)
+        {
+            child = malloc(ft_strlen(path) + ft_strlen(entry->d_name) + 2);
+            if (child == NULL)
+                break;
+            ft_strcat(ft_strcat(ft_strcpy(child, path), "/"), entry->d_name);
+            if (!dupes_collect(args, list, child))
+            {
+                free(child);
+                break;
+            }
+            free(child);
+        }
+        entry = readdir(dir);
+    }
+    closedir(dir);
+    return entry == NULL;
+}
+
+/*
+ * hash the first and last DUPES_EDGE bytes of a file
+ * small files are hashed whole so the partial digest is the real digest
+ */
+static void dupes_partial(t_args *args, t_dupe *dupe)
+{
+    uint8_t buffer[DUPES_EDGE * 2];
+    ssize_t tail;
+    ssize_t len;
+    int fd;
+
+    fd = open(dupe->path, O_RDONLY);
+    if (fd == -1)
+    {
+        error_msg(args->hash, dupe->path, NULL);
+        dupe->valid = 0;
+        return;
+    }
+    hash_initialize(args);
+    if (dupe->size <= sizeof(buffer))
+        len = pread(fd, buffer, dupe->size, 0);
+    else
+    {
+        len = pread(fd, buffer, DUPES_EDGE, 0);
+        if (len == DUPES_EDGE)
+        {
+            tail = pread(fd, buffer + DUPES_EDGE, DUPES_EDGE, dupe->size - DUPES_EDGE);
+            len = (tail < 0) ? tail : len + tail;
+        }
+    }
+    close(fd);
+    if (len < 0)
+    {
+        error_msg(args->hash, dupe->path, NULL);
+        dupe->valid = 0;
+        return;
+    }
+    // a file that changed size since it was listed can't be compared
+    if ((uint64_t)len != (dupe->size <= sizeof(buffer) ? dupe->size : sizeof(buffer)))
+    {
+        error_msg(args->hash, dupe->path, "file changed while reading");
+        dupe->valid = 0;
+        return;
+    }
+    hash_add_bytes(args, buffer, len);
+    hash_finalize(args);
+    hash_digest(args, dupe->partial);
+}
+
+/*
+ * hash the whole file with the same code used for file inputs
+ */
+static void dupes_full(t_args *args, t_dupe *dupe)
+{
+    int fd;
+
+    fd = open(dupe->path, O_RDONLY);
+    if (fd == -1 || !hash_fd(args, fd))
+    {
+        error_msg(args->hash, dupe->path, NULL);
+        dupe->valid = 0;
+    }
+    else
+        hash_digest(args, dupe->full);
+    if (fd != -1)
+        close(fd);
+}
+
+/*
+ * length of the run of entries equal to the first one up to the given stage
+ * stage 0 compares size, 1 adds the partial digest and 2 the full digest
+ */
+static size_t dupes_run(t_dupe *list, size_t count, int stage)
+{
+    size_t i;
+
+    for (i = 1; i < count; i++)
+    {
+        if (list[i].size != list[0].size || list[i].valid != list[0].valid)
+            break;
+        if (stage >= 1 && memcmp(list[i].partial, list[0].partial, 32) != 0)
+            break;
+        if (stage >= 2 && memcmp(list[i].full, list[0].full, 32) != 0)
+            break;
+    }
+    return i;
+}
+
+static void dupes_print(t_args *args, t_dupe *group, size_t count, int *first)
+{
+    char digest[65];
+    size_t i;
+
+    // the partial digest covers small files completely
+    if (group[0].size <= DUPES_EDGE * 2)
+        encode_hex(group[0].partial, 32, digest);
+    else
+        encode_hex(group[0].full, 32, digest);
+    // groups are separated by an empty line
+    if (!*first)
+        ft_putstr(1, "\n");
+    *first = 0;
+    for (i = 0; i < count; i++)
+    {
+        if (!(args->flags & (FT_REVERSE | FT_QUIET)))
+            ft_putstr(6, args->HASH, " (", group[i].path, ") = ", digest, "\n");
+        else if (args->flags & FT_REVERSE && !(args->flags & FT_QUIET))
+            ft_putstr(4, digest, " ", group[i].path, "\n");
+        else
+            ft_putstr(2, group[i].path, "\n");
+    }
+}
+
+/*
+ * narrow down a group of same size files and print the real duplicates
+ * every stage only reads files that still have a possible match
+ */
+static void dupes_group(t_args *args, t_dupe *group, size_t count, int *first)
+{
+    size_t run;
+    size_t full;
+    size_t i;
+
+    for (i = 0; i < count; i++)
+        dupes_partial(args, &group[i]);
+    qsort(group, count, sizeof(t_dupe), dupes_compare);
+    while (count > 0)
+    {
+        run = dupes_run(group, count, 1);
+        if (run > 1 && group[0].valid && group[0].size > DUPES_EDGE * 2)
+        {
+            for (i = 0; i < run; i++)
+                dupes_full(args, &group[i]);
+            qsort(group, run, sizeof(t_dupe), dupes_compare);
+            i = 0;
+            while (i < run)
+            {
+                full = dupes_run(group + i, run - i, 2);
+                if (full > 1 && group[i].valid)
+                    dupes_print(args, group + i, full, first);
+                i += full;
+            }
+        }
+        else if (run > 1 && group[0].valid)
+            dupes_print(args, group, run, first);
+        group += run;
+        count -= run;
+    }
+}
+
+/*
+ * print groups of files with identical contents
+ * files are grouped by size, then by a hash of both ends
+ * and only then by a full digest
+ */
+int process_dupes(t_args *args)
+{
+    t_dynar array;
+    t_dupe *list;
+    size_t count;
+    size_t run;
+    size_t i;
+    int first;
+
+    if (!dynar_init(&array))
+        return 0;
+    for (i = 0; args->files[i] != NULL; i++)
+    {
+        if (!dupes_collect(args, &array, args->files[i]))
+        {
+            dynar_free(&array);
+            return 0;
+        }
+    }
+    list = (t_dupe *)array.buffer;
+    count = dupes_unique(list, array.size / sizeof(t_dupe));
+    qsort(list, count, sizeof(t_dupe), dupes_compare);
+    first = 1;
+    i = 0;
+    while (i < count)
+    {
+        run = dupes_run(list + i, count - i, 0);
+        if (run > 1)
+            dupes_group(args, list + i, run, &first);
+        i += run;
+    }
+    for (i = 0; i < count; i++)
+        free(list[i].path);
+    dynar_free(&array);
+    return 1;
+}
@@ -8,6 +8,9 @@ static int dynar_grow(t_dynar *array, size_t capacity)
 
     if (capacity <= array->capacity)
         return 1;
+    // at least double so appending many small pieces stays linear
+    if (capacity < array->capacity * 2)
+        capacity = array->capacity * 2;
     capacity2 = (capacity + 1048576) / 1048576 * 1048576;
     buffer2 = malloc(capacity2);
     if (buffer2 == NULL)
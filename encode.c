@@ -0,0 +1,114 @@
+#include "encode.h"
+
+/*
+ * every byte value as two lowercase hex characters
+ * lets the encoder emit a whole byte with one lookup instead of two nibbles
+ */
+static const char encode_hex_table[513] =
+    "000102030405060708090a0b0c0d0e0f"
+    "101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f"
+    "303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f"
+    "505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f"
+    "707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f"
+    "909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeaf"
+    "b0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+    "d0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+    "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+/*
+ * base64 alphabet from RFC4648
+ */
+static const char encode_base64_table[65] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*
+ * convert a byte array to a lowercase hex string
+ * dst must have at least len * 2 + 1 bytes for the string and null
+ */
+char *encode_hex(const uint8_t *bytes, size_t len, char *dst)
+{
+    const char *pair;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        pair = &encode_hex_table[bytes[i] * 2];
+        dst[i * 2] = pair[0];
+        dst[i * 2 + 1] = pair[1];
+    }
+    dst[len * 2] = '\0';
+    return dst;
+}
+
+/*
+ * convert a byte array to a padded base64 string
+ * dst must have at least (len + 2) / 3 * 4 + 1 bytes for the string and null
+ */
+char *encode_base64(const uint8_t *bytes, size_t len, char *dst)
+{
+    uint32_t num;
+    char *ret;
+
+    ret = dst;
+    while (len >= 3)
+    {
+        num = ((uint32_t)bytes[0] << 16) | ((uint32_t)bytes[1] << 8) | bytes[2];
+        dst[0] = encode_base64_table[num >> 18];
+        dst[1] = encode_base64_table[(num >> 12) & 0x3f];
+        dst[2] = encode_base64_table[(num >> 6) & 0x3f];
+        dst[3] = encode_base64_table[num & 0x3f];
+        bytes += 3;
+        len -= 3;
+        dst += 4;
+    }
+    // pad the last group of 1 or 2 bytes with '='
+    if (len > 0)
+    {
+        num = (uint32_t)bytes[0] << 16;
+        if (len == 2)
+            num |= (uint32_t)bytes[1] << 8;
+        dst[0] = encode_base64_table[num >> 18];
+        dst[1] = encode_base64_table[(num >> 12) & 0x3f];
+        dst[2] = (len == 2) ? encode_base64_table[(num >> 6) & 0x3f] : '=';
+        dst[3] = '=';
+        dst += 4;
+    }
+    *dst = '\0';
+    return ret;
+}
+
+/*
+ * convert len hex characters to len / 2 bytes
+ * returns 0 if a character isn't a hex digit
+ */
+int decode_hex(const char *src, size_t len, uint8_t *dst)
+{
+    uint8_t num;
+    size_t i;
+    char c;
+
+    for (i = 0; i < len; i++)
+    {
+        c = src[i];
+        if (c >= '0' && c <= '9')
+            num = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            num = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            num = c - 'A' + 10;
+        else
+            return 0;
+        if (i % 2 == 0)
+            dst[i / 2] = num << 4;
+        else
+            dst[i / 2] |= num;
+    }
+    return 1;
+}
@@ -0,0 +1,11 @@
+#ifndef ENCODE_H
+#define ENCODE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+char *encode_hex(const uint8_t *bytes, size_t len, char *dst);
+char *encode_base64(const uint8_t *bytes, size_t len, char *dst);
+int decode_hex(const char *src, size_t len, uint8_t *dst);
+
+#endif
@@ -1,35 +1,21 @@
-#include "md5.h"
-#include "sha256.h"
+// SEEK_DATA, SEEK_HOLE and O_DIRECT are linux extensions
+#define _GNU_SOURCE
+
+#include "ft_ssl.h"
 #include "libft.h"
 #include "dynar.h"
+#include "encode.h"
 #include <unistd.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <fcntl.h>
-
-#define FT_MD5 1
-#define FT_SHA256 2
-#define FT_FILES 4
-#define FT_PASSTHRU 8
-#define FT_QUIET 16
-#define FT_REVERSE 32
-#define FT_STRING 64
-#define FT_STDIN 128
-
-typedef struct s_args
-{
-    int flags;
-    char hash[8];
-    char HASH[8];
-    char *string;
-    char **files;
-    t_md5 md5;
-    t_sha256 sha;
-} t_args;
+#include <sys/stat.h>
 
 void error_msg(char *prefix, char *subject, char *message)
 {
+    // keep stdout and stderr in order
+    ft_flush();
     ft_puterr(1, "ft_ssl: ");
     if (prefix != NULL)
         ft_puterr(2, prefix, ": ");
@@ -50,15 +36,129 @@ void error_exit(char *prefix, char *subject, char *message)
 void usage_exit(char *prefix, char *subject, char *message)
 {
     error_msg(prefix, subject, message);
-    ft_puterr(1, "usage: ft_ssl <md5|sha256> [-p -q -r] [-s string] [files ...]\n");
+    ft_puterr(1, "usage: ft_ssl <md5|sha256|blake2s|blake2b|blake3|chunk|dupes|mkdb|pbkdf2> [-p -q -r] [--per-line | --per-record0] [--format fmt] [--direct] [--match db] [--offset n] [--length n] [--tar] [--kernel] [-s string] [files ...]\n");
+    ft_puterr(1, "commands:\n");
+    ft_puterr(1, "    md5      print the md5 sum of each input\n");
+    ft_puterr(1, "    sha256   print the sha256 sum of each input\n");
+    ft_puterr(1, "    blake2s  print the blake2s-256 sum of each input\n");
+    ft_puterr(1, "    blake2b  print the blake2b-512 sum of each input\n");
+    ft_puterr(1, "    blake3   print the blake3 sum of each input, large files\n");
+    ft_puterr(1, "             are hashed on every cpu\n");
+    ft_puterr(1, "    chunk    split each input into content defined chunks and\n");
+    ft_puterr(1, "             print the offset, length and sha256 of every chunk\n");
+    ft_puterr(1, "    dupes    search the given files and directories for files\n");
+    ft_puterr(1, "             with identical contents and print them in groups\n");
+    ft_puterr(1, "    mkdb     build a --match database from lists of hex digests\n");
+    ft_puterr(1, "             and write it to STDOUT, --bloom adds a bloom filter\n");
+    ft_puterr(1, "             --hash name names the hash of lists without names\n");
+    ft_puterr(1, "    pbkdf2   derive a PBKDF2-HMAC-SHA256 key from -s password and\n");
+    ft_puterr(1, "             --salt salt with --iter n (10000) and --keylen n (32)\n");
+    ft_puterr(1, "             --batch reads password<TAB>salt lines from the inputs\n");
     ft_puterr(1, "options:\n");
     ft_puterr(1, "    -p   echo STDIN to STDOUT and append the checksum to STDOUT\n");
     ft_puterr(1, "    -q   quiet mode\n");
     ft_puterr(1, "    -r   reverse the format of the output\n");
     ft_puterr(1, "    -s   print the sum of the given string\n");
+    ft_puterr(1, "    --per-line      print the sum of every line of STDIN\n");
+    ft_puterr(1, "    --per-record0   print the sum of every NUL terminated record of STDIN\n");
+    ft_puterr(1, "    --format fmt    print sums as hex (default), base64, raw or record\n");
+    ft_puterr(1, "                    raw writes only the binary digests\n");
+    ft_puterr(1, "                    record writes the binary digest, a 32bit big-endian\n");
+    ft_puterr(1, "                    name length and the name for every input\n");
+    ft_puterr(1, "    --direct        read files with O_DIRECT to bypass the page cache\n");
+    ft_puterr(1, "    --match db      only print sums found in a database built by mkdb\n");
+    ft_puterr(1, "    --offset n      start a byte range of each file at offset n\n");
+    ft_puterr(1, "    --length n      limit the last byte range to n bytes\n");
+    ft_puterr(1, "                    several ranges can be given and are hashed in parallel\n");
+    ft_puterr(1, "    --tar           read inputs as tar archives and print the sum of every file\n");
+    ft_puterr(1, "    --kernel        hash files with the kernel crypto api when it is available\n");
     exit(EXIT_FAILURE);
 }
 
+/*
+ * add a byte range for --offset or set the length of the last one
+ * a --length before any --offset starts a range at offset 0
+ */
+void read_range(t_args *args, char *option, char *value, int argc)
+{
+    unsigned long long num;
+
+    if (value == NULL)
+        usage_exit(args->hash, option, "missing number");
+    if (!ft_strtou(value, &num))
+        usage_exit(args->hash, value, "invalid number");
+    // there can't be more ranges than arguments
+    if (args->ranges == NULL)
+    {
+        args->ranges = malloc(sizeof(t_range) * argc);
+        if (args->ranges == NULL)
+            error_exit(args->hash, NULL, NULL);
+    }
+    args->flags |= FT_RANGES;
+    if (ft_strcmp(option, "--offset") == 0 || args->range_count == 0)
+    {
+        args->ranges[args->range_count].offset = 0;
+        args->ranges[args->range_count].length = ~0ULL;
+        args->range_count++;
+    }
+    if (ft_strcmp(option, "--offset") == 0)
+        args->ranges[args->range_count - 1].offset = num;
+    else
+        args->ranges[args->range_count - 1].length = num;
+}
+
+/*
+ * read --iter or --keylen, both have to be at least 1
+ */
+void read_pbkdf2_number(t_args *args, char *option, char *value)
+{
+    unsigned long long num;
+
+    if (value == NULL)
+        usage_exit(args->hash, option, "missing number");
+    if (!ft_strtou(value, &num) || num == 0)
+        usage_exit(args->hash, value, "invalid number");
+    if (ft_strcmp(option, "--iter") == 0)
+        args->iterations = num;
+    else if (num > 1024)
+        usage_exit(args->hash, value, "keys are limited to 1024 bytes");
+    else
+        args->keylen = num;
+}
+
+/*
+ * read the --hash of mkdb, a hash command name stored upper case like
+ * in "HASH (name) = digest" lines
+ */
+void read_mkdb_hash(t_args *args, char *value)
+{
+    int i;
+
+    if (value == NULL)
+        usage_exit(args->hash, "--hash", "missing hash name");
+    for (i = 0; value[i] != '\0' && i < 7; i++)
+        args->HASH[i] = value[i] >= 'a' && value[i] <= 'z' ? value[i] - 32 : value[i];
+    args->HASH[i] = '\0';
+    if (value[i] != '\0' || matchdb_hash_size(args->HASH) == 0)
+        usage_exit(args->hash, value, "invalid hash name");
+}
+
+/*
+ * map a --match database and check it was built for this hash
+ */
+void open_match(t_args *args, char *path)
+{
+    int ret;
+
+    ret = matchdb_open(&args->match, path);
+    if (ret == 0)
+        error_exit(args->hash, path, NULL);
+    if (ret < 0)
+        error_exit(args->hash, path, "not a digest database");
+    if (ft_strcmp(args->match.hash, args->HASH) != 0)
+        error_exit(args->hash, path, "database was built for another hash");
+}
+
 void read_args(int argc, char **argv, t_args *args)
 {
     int i;
@@ -68,6 +168,11 @@ void read_args(int argc, char **argv, t_args *args)
     args->HASH[0] = '\0';
     args->string = NULL;
     args->files = NULL;
+    args->ranges = NULL;
+    args->range_count = 0;
+    args->salt = NULL;
+    args->iterations = 10000;
+    args->keylen = 32;
 
     // check for valid hash function
     if (argc < 2)
@@ -86,6 +191,47 @@ void read_args(int argc, char **argv, t_args *args)
         ft_strcpy(args->hash, "sha256");
         ft_strcpy(args->HASH, "SHA256");
     }
+    else if (ft_strcmp(argv[1], "blake2s") == 0)
+    {
+        args->flags |= FT_BLAKE2S;
+        ft_strcpy(args->hash, "blake2s");
+        ft_strcpy(args->HASH, "BLAKE2S");
+    }
+    else if (ft_strcmp(argv[1], "blake2b") == 0)
+    {
+        args->flags |= FT_BLAKE2B;
+        ft_strcpy(args->hash, "blake2b");
+        ft_strcpy(args->HASH, "BLAKE2B");
+    }
+    else if (ft_strcmp(argv[1], "blake3") == 0)
+    {
+        args->flags |= FT_BLAKE3;
+        ft_strcpy(args->hash, "blake3");
+        ft_strcpy(args->HASH, "BLAKE3");
+    }
+    else if (ft_strcmp(argv[1], "chunk") == 0)
+    {
+        args->flags |= FT_SHA256 | FT_CHUNK;
+        ft_strcpy(args->hash, "chunk");
+        ft_strcpy(args->HASH, "SHA256");
+    }
+    else if (ft_strcmp(argv[1], "dupes") == 0)
+    {
+        args->flags |= FT_SHA256 | FT_DUPES;
+        ft_strcpy(args->hash, "dupes");
+        ft_strcpy(args->HASH, "SHA256");
+    }
+    else if (ft_strcmp(argv[1], "mkdb") == 0)
+    {
+        args->flags |= FT_MKDB;
+        ft_strcpy(args->hash, "mkdb");
+    }
+    else if (ft_strcmp(argv[1], "pbkdf2") == 0)
+    {
+        args->flags |= FT_SHA256 | FT_PBKDF2;
+        ft_strcpy(args->hash, "pbkdf2");
+        ft_strcpy(args->HASH, "PBKDF2");
+    }
     else
         usage_exit(NULL, argv[1], "invalid hash function");
 
@@ -98,6 +244,69 @@ void read_args(int argc, char **argv, t_args *args)
             args->flags |= FT_QUIET;
         else if (ft_strcmp(argv[i], "-r") == 0)
             args->flags |= FT_REVERSE;
+        else if (ft_strcmp(argv[i], "--per-line") == 0)
+            args->flags |= FT_LINES;
+        else if (ft_strcmp(argv[i], "--per-record0") == 0)
+            args->flags |= FT_RECORD0;
+        else if (ft_strcmp(argv[i], "--direct") == 0)
+            args->flags |= FT_DIRECT;
+        else if (ft_strcmp(argv[i], "--tar") == 0)
+            args->flags |= FT_TAR;
+        else if (ft_strcmp(argv[i], "--kernel") == 0)
+            args->flags |= FT_KERNEL;
+        else if (ft_strcmp(argv[i], "--offset") == 0
+            || ft_strcmp(argv[i], "--length") == 0)
+        {
+            read_range(args, argv[i], argv[i + 1], argc);
+            i++;
+        }
+        else if (ft_strcmp(argv[i], "--bloom") == 0 && args->flags & FT_MKDB)
+            args->flags |= FT_BLOOM;
+        else if (ft_strcmp(argv[i], "--hash") == 0 && args->flags & FT_MKDB)
+        {
+            read_mkdb_hash(args, argv[i + 1]);
+            i++;
+        }
+        else if (ft_strcmp(argv[i], "--batch") == 0 && args->flags & FT_PBKDF2)
+            args->flags |= FT_BATCH;
+        else if (ft_strcmp(argv[i], "--salt") == 0 && args->flags & FT_PBKDF2)
+        {
+            if (argv[i + 1] == NULL)
+                usage_exit(args->hash, "--salt", "missing salt");
+            args->salt = argv[i + 1];
+            i++;
+        }
+        else if ((ft_strcmp(argv[i], "--iter") == 0 || ft_strcmp(argv[i], "--keylen") == 0)
+            && args->flags & FT_PBKDF2)
+        {
+            read_pbkdf2_number(args, argv[i], argv[i + 1]);
+            i++;
+        }
+        else if (ft_strcmp(argv[i], "--match") == 0)
+        {
+            if (argv[i + 1] == NULL)
+                usage_exit(args->hash, "--match", "missing database");
+            if (args->flags & FT_MATCH)
+                matchdb_close(&args->match);
+            args->flags |= FT_MATCH;
+            open_match(args, argv[i + 1]);
+            i++;
+        }
+        else if (ft_strcmp(argv[i], "--format") == 0)
+        {
+            if (argv[i + 1] == NULL)
+                usage_exit(args->hash, "--format", "missing format");
+            args->flags &= ~(FT_BASE64 | FT_BINARY);
+            if (ft_strcmp(argv[i + 1], "base64") == 0)
+                args->flags |= FT_BASE64;
+            else if (ft_strcmp(argv[i + 1], "raw") == 0)
+                args->flags |= FT_RAW;
+            else if (ft_strcmp(argv[i + 1], "record") == 0)
+                args->flags |= FT_FIXED;
+            else if (ft_strcmp(argv[i + 1], "hex") != 0)
+                usage_exit(args->hash, argv[i + 1], "invalid format");
+            i++;
+        }
         else if (ft_strcmp(argv[i], "-s") == 0)
         {
             args->flags |= FT_STRING;
@@ -117,8 +326,50 @@ void read_args(int argc, char **argv, t_args *args)
         args->files = &argv[i];
     }
 
-    // if no inputs use stdin
-    if (!(args->flags & (FT_PASSTHRU | FT_STRING | FT_FILES)))
+    // per record mode splits stdin so it can't echo it or use other inputs
+    if ((args->flags & FT_RECORDS) == FT_RECORDS)
+        usage_exit(args->hash, "--per-line", "cannot be used with --per-record0");
+    if (args->flags & FT_RECORDS && args->flags & FT_PASSTHRU)
+        usage_exit(args->hash, "-p", "cannot be used with per record mode");
+
+    // chunk and dupes only work on whole streams or files
+    if (args->flags & (FT_CHUNK | FT_DUPES)
+        && args->flags & (FT_PASSTHRU | FT_STRING | FT_RECORDS))
+        usage_exit(args->hash, NULL, "-p, -s and per record modes can't be used with this command");
+    if (args->flags & FT_DUPES && !(args->flags & FT_FILES))
+        usage_exit(args->hash, NULL, "missing files");
+    // only whole file hashing knows how to read an O_DIRECT fd
+    if (args->flags & FT_CHUNK && args->flags & FT_DIRECT)
+        usage_exit(args->hash, "--direct", "cannot be used with chunk");
+
+    // ranges are read with pread so they only work on files
+    if (args->flags & FT_RANGES
+        && (args->flags & (FT_CHUNK | FT_DUPES | FT_MKDB | FT_RECORDS | FT_DIRECT)
+            || !(args->flags & FT_FILES)))
+        usage_exit(args->hash, "--offset", "byte ranges only work on files with a hash command");
+
+    // tar members are streamed one after another
+    if (args->flags & FT_TAR
+        && args->flags & (FT_CHUNK | FT_DUPES | FT_MKDB | FT_RECORDS | FT_RANGES | FT_PASSTHRU
+            | FT_DIRECT))
+        usage_exit(args->hash, "--tar", "can only be used with a hash command without -p or --direct");
+
+    // pbkdf2 takes a password and salt or batch inputs
+    if (args->flags & FT_PBKDF2 && !(args->flags & FT_BATCH)
+        && (args->flags & ~(FT_SHA256 | FT_PBKDF2 | FT_STRING | FT_QUIET | FT_REVERSE)
+            || args->string == NULL || args->salt == NULL))
+        usage_exit(args->hash, NULL, "needs -s password and --salt salt");
+    if (args->flags & FT_BATCH
+        && args->flags & ~(FT_SHA256 | FT_PBKDF2 | FT_BATCH | FT_FILES))
+        usage_exit(args->hash, "--batch", "only takes input files");
+
+    // mkdb only takes digest lists
+    if (args->flags & FT_MKDB && args->flags & ~(FT_MKDB | FT_BLOOM | FT_FILES))
+        usage_exit(args->hash, NULL, "only --bloom and --hash can be used with mkdb");
+
+    // if no inputs use stdin, per record mode always reads stdin
+    if (!(args->flags & (FT_PASSTHRU | FT_STRING | FT_FILES))
+        || args->flags & FT_RECORDS)
         args->flags |= FT_STDIN;
 }
 
@@ -128,6 +379,12 @@ void hash_initialize(t_args *args)
         md5_initialize(&args->md5);
     else if (args->flags & FT_SHA256)
         sha256_initialize(&args->sha);
+    else if (args->flags & FT_BLAKE2S)
+        blake2s_initialize(&args->b2s);
+    else if (args->flags & FT_BLAKE2B)
+        blake2b_initialize(&args->b2b);
+    else if (args->flags & FT_BLAKE3)
+        blake3_initialize(&args->b3);
 }
 
 void hash_add_byte(t_args *args, uint8_t byte)
@@ -136,6 +393,40 @@ void hash_add_byte(t_args *args, uint8_t byte)
         md5_add_byte(&args->md5, byte);
     else if (args->flags & FT_SHA256)
         sha256_add_byte(&args->sha, byte);
+    else if (args->flags & FT_BLAKE2S)
+        blake2s_add_byte(&args->b2s, byte);
+    else if (args->flags & FT_BLAKE2B)
+        blake2b_add_byte(&args->b2b, byte);
+    else if (args->flags & FT_BLAKE3)
+        blake3_add_byte(&args->b3, byte);
+}
+
+void hash_add_bytes(t_args *args, const uint8_t *bytes, uint64_t len)
+{
+    if (args->flags & FT_MD5)
+        md5_add_bytes(&args->md5, bytes, len);
+    else if (args->flags & FT_SHA256)
+        sha256_add_bytes(&args->sha, bytes, len);
+    else if (args->flags & FT_BLAKE2S)
+        blake2s_add_bytes(&args->b2s, bytes, len);
+    else if (args->flags & FT_BLAKE2B)
+        blake2b_add_bytes(&args->b2b, bytes, len);
+    else if (args->flags & FT_BLAKE3)
+        blake3_add_bytes(&args->b3, bytes, len);
+}
+
+void hash_add_zeros(t_args *args, uint64_t len)
+{
+    if (args->flags & FT_MD5)
+        md5_add_zeros(&args->md5, len);
+    else if (args->flags & FT_SHA256)
+        sha256_add_zeros(&args->sha, len);
+    else if (args->flags & FT_BLAKE2S)
+        blake2s_add_zeros(&args->b2s, len);
+    else if (args->flags & FT_BLAKE2B)
+        blake2b_add_zeros(&args->b2b, len);
+    else if (args->flags & FT_BLAKE3)
+        blake3_add_zeros(&args->b3, len);
 }
 
 void hash_finalize(t_args *args)
@@ -144,19 +435,117 @@ void hash_finalize(t_args *args)
         md5_finalize(&args->md5);
     else if (args->flags & FT_SHA256)
         sha256_finalize(&args->sha);
+    else if (args->flags & FT_BLAKE2S)
+        blake2s_finalize(&args->b2s);
+    else if (args->flags & FT_BLAKE2B)
+        blake2b_finalize(&args->b2b);
+    else if (args->flags & FT_BLAKE3)
+        blake3_finalize(&args->b3);
 }
 
-void hash_string(t_args *args, char *dst)
+/*
+ * size of the raw digest of the selected hash
+ */
+int hash_size(t_args *args)
+{
+    if (args->flags & FT_MD5)
+        return 16;
+    if (args->flags & FT_BLAKE2B)
+        return 64;
+    return 32;
+}
+
+/*
+ * copy the raw digest to dst and return its size
+ * dst must have at least FT_DIGEST_MAX bytes
+ */
+int hash_digest(t_args *args, uint8_t *dst)
 {
     if (args->flags & FT_MD5)
-        md5_string(&args->md5, dst);
+        md5_digest(&args->md5, dst);
     else if (args->flags & FT_SHA256)
-        sha256_string(&args->sha, dst);
+        sha256_digest(&args->sha, dst);
+    else if (args->flags & FT_BLAKE2S)
+        blake2s_digest(&args->b2s, dst);
+    else if (args->flags & FT_BLAKE2B)
+        blake2b_digest(&args->b2b, dst);
+    else if (args->flags & FT_BLAKE3)
+        blake3_digest(&args->b3, dst);
+    return hash_size(args);
+}
+
+/*
+ * convert the digest to a hex or base64 string
+ * dst must have at least FT_DIGEST_MAX * 2 + 1 bytes for the digest and null
+ */
+void hash_string(t_args *args, char *dst)
+{
+    uint8_t digest[FT_DIGEST_MAX];
+    int len;
+
+    len = hash_digest(args, digest);
+    if (args->flags & FT_BASE64)
+        encode_base64(digest, len, dst);
+    else
+        encode_hex(digest, len, dst);
+}
+
+/*
+ * in match mode only digests found in the database are printed
+ * returns 1 when the digest shouldn't be printed
+ */
+int hash_skip(t_args *args)
+{
+    uint8_t digest[FT_DIGEST_MAX];
+
+    if (!(args->flags & FT_MATCH))
+        return 0;
+    hash_digest(args, digest);
+    return !matchdb_contains(&args->match, digest);
+}
+
+/*
+ * write the digest in one of the binary formats
+ * the record name is name, followed by " @ " and at when at isn't NULL
+ * returns 0 when the output format is text and nothing was written
+ */
+int print_binary_at(t_args *args, char *name, char *at)
+{
+    uint8_t digest[FT_DIGEST_MAX];
+    uint8_t prefix[4];
+    uint32_t len;
+
+    if (!(args->flags & FT_BINARY))
+        return 0;
+    ft_putbytes(digest, hash_digest(args, digest));
+    if (args->flags & FT_FIXED)
+    {
+        len = ft_strlen(name);
+        if (at != NULL)
+            len += 3 + ft_strlen(at);
+        prefix[0] = len >> 24;
+        prefix[1] = (len >> 16) & 0xff;
+        prefix[2] = (len >> 8) & 0xff;
+        prefix[3] = len & 0xff;
+        ft_putbytes(prefix, sizeof(prefix));
+        ft_putbytes(name, ft_strlen(name));
+        if (at != NULL)
+        {
+            ft_putbytes(" @ ", 3);
+            ft_putbytes(at, ft_strlen(at));
+        }
+    }
+    return 1;
+}
+
+int print_binary(t_args *args, char *name)
+{
+    return print_binary_at(args, name, NULL);
 }
 
 void process_string(t_args *args)
 {
-    char digest[65];
+    char digest[FT_DIGEST_MAX * 2 + 1];
     int len;
     int i;
 
@@ -166,6 +555,8 @@ void process_string(t_args *args)
     for (i = 0; i < len; i++)
         hash_add_byte(args, args->string[i]);
     hash_finalize(args);
+    if (hash_skip(args) || print_binary(args, args->string))
+        return;
     hash_string(args, digest);
 
     if (!(args->flags & (FT_REVERSE | FT_QUIET)))
@@ -176,43 +567,144 @@ void process_string(t_args *args)
         ft_putstr(2, digest, "\n");
 }
 
-int process_file(t_args *args, int fd)
+/*
+ * hash a sparse file one extent at a time
+ * holes are found with SEEK_DATA/SEEK_HOLE and hashed as zeros without
+ * reading them, only the data extents go through read
+ */
+static int hash_extents(t_args *args, int fd, off_t pos, off_t size)
 {
-    uint8_t buffer[1024];
-    char digest[65];
-    int len;
-    int i;
+    uint8_t buffer[65536];
+    off_t data;
+    off_t hole;
+    ssize_t len;
 
+    while (pos < size)
+    {
+        // no data after pos means the rest is a hole
+        // any other error means extents aren't supported so read it all
+        data = lseek(fd, pos, SEEK_DATA);
+        if (data == -1)
+            data = (errno == ENXIO) ? size : pos;
+        hole = size;
+        if (data < size)
+        {
+            hole = lseek(fd, data, SEEK_HOLE);
+            if (hole == -1 || hole > size)
+                hole = size;
+        }
+        hash_add_zeros(args, data - pos);
+        pos = data;
+        if (pos < hole && lseek(fd, pos, SEEK_SET) == -1)
+            return 0;
+        while (pos < hole)
+        {
+            len = hole - pos;
+            if (len > (ssize_t)sizeof(buffer))
+                len = sizeof(buffer);
+            len = read(fd, buffer, len);
+            if (len < 0)
+                return 0;
+            // the file got shorter, stop where a normal read would
+            if (len == 0)
+                return 1;
+            hash_add_bytes(args, buffer, len);
+            pos += len;
+        }
+    }
+    return 1;
+}
+
+/*
+ * hash everything left in fd and finalize the digest
+ * regular files with holes are hashed extent by extent
+ */
+int hash_fd(t_args *args, int fd)
+{
+    uint8_t buffer[65536];
+    struct stat st;
+    ssize_t len;
+    off_t pos;
+    int ret;
+
+    // the kernel finalizes the digest itself
+    if (args->flags & FT_KERNEL)
+    {
+        ret = hash_kernel(args, fd);
+        if (ret != 0)
+            return ret == 1;
+    }
     hash_initialize(args);
+    // large blake3 files are hashed a subtree per thread, the rest is read below
+    if (args->flags & FT_BLAKE3 && !(args->flags & FT_DIRECT)
+        && !blake3_add_fd(&args->b3, fd))
+        return 0;
+    if (args->flags & FT_DIRECT)
+    {
+        if (!hash_direct(args, fd))
+            return 0;
+        hash_finalize(args);
+        return 1;
+    }
+    // fewer allocated blocks than the size means there are holes
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)
+        && st.st_blocks * 512 < st.st_size)
+    {
+        pos = lseek(fd, 0, SEEK_CUR);
+        if (pos != -1)
+        {
+            if (!hash_extents(args, fd, pos, st.st_size))
+                return 0;
+            hash_finalize(args);
+            return 1;
+        }
+    }
     len = read(fd, buffer, sizeof(buffer));
     while (len > 0)
     {
-        for (i = 0; i < len; i++)
-            hash_add_byte(args, buffer[i]);
+        hash_add_bytes(args, buffer, len);
         len = read(fd, buffer, sizeof(buffer));
     }
     if (len < 0)
         return 0;
     hash_finalize(args);
+    return 1;
+}
+
+/*
+ * print a finished digest in the file input format
+ */
+void print_file(t_args *args, char *name)
+{
+    char digest[FT_DIGEST_MAX * 2 + 1];
+
+    if (hash_skip(args) || print_binary(args, name))
+        return;
     hash_string(args, digest);
 
     if (!(args->flags & (FT_REVERSE | FT_QUIET)))
-        ft_putstr(6, args->HASH, " (", args->files[0], ") = ", digest, "\n");
+        ft_putstr(6, args->HASH, " (", name, ") = ", digest, "\n");
     else if (args->flags & FT_REVERSE && !(args->flags & FT_QUIET))
-        ft_putstr(4, digest, " ", args->files[0], "\n");
+        ft_putstr(4, digest, " ", name, "\n");
     else
         ft_putstr(2, digest, "\n");
+}
+
+int process_file(t_args *args, int fd)
+{
+    if (!hash_fd(args, fd))
+        return 0;
+    print_file(args, args->files[0]);
 
     return 1;
 }
 
 int process_stdin(t_args *args)
 {
-    uint8_t buffer[1024];
+    uint8_t buffer[65536];
     t_dynar array;
-    char digest[65];
+    char digest[FT_DIGEST_MAX * 2 + 1];
     int len;
-    int i;
 
     if (!dynar_init(&array))
         return 0;
@@ -220,8 +712,7 @@ int process_stdin(t_args *args)
     len = read(STDIN_FILENO, buffer, sizeof(buffer));
     while (len > 0)
     {
-        for (i = 0; i < len; i++)
-            hash_add_byte(args, buffer[i]);
+        hash_add_bytes(args, buffer, len);
 
         if (args->flags & FT_PASSTHRU
             && !dynar_append(&array, (char *)buffer, len))
@@ -233,8 +724,17 @@ int process_stdin(t_args *args)
         len = read(STDIN_FILENO, buffer, sizeof(buffer));
     }
     if (len < 0)
+    {
+        dynar_free(&array);
         return 0;
+    }
     hash_finalize(args);
+    // binary output is only the digest so stdin isn't echoed
+    if (hash_skip(args) || print_binary(args, "stdin"))
+    {
+        dynar_free(&array);
+        return 1;
+    }
     hash_string(args, digest);
 
     // don't print new line on the end
@@ -254,6 +754,80 @@ int process_stdin(t_args *args)
     return 1;
 }
 
+/*
+ * finish the current record and print its digest
+ * records are numbered from 1 in the order they appear on stdin
+ */
+void print_record(t_args *args, uint64_t record)
+{
+    char digest[FT_DIGEST_MAX * 2 + 1];
+    char name[28];
+    char number[21];
+
+    hash_finalize(args);
+    ft_utoa(record, number);
+    if (hash_skip(args))
+        return;
+    if (print_binary(args, ft_strcat(ft_strcpy(name, "stdin:"), number)))
+        return;
+    hash_string(args, digest);
+
+    if (!(args->flags & (FT_REVERSE | FT_QUIET)))
+        ft_putstr(5, "(stdin:", number, ")= ", digest, "\n");
+    else if (args->flags & FT_REVERSE && !(args->flags & FT_QUIET))
+        ft_putstr(4, digest, " stdin:", number, "\n");
+    else
+        ft_putstr(2, digest, "\n");
+}
+
+/*
+ * hash every line or NUL terminated record of stdin separately
+ * records are hashed straight out of the read buffer and never copied
+ * a record split across two reads just keeps adding to the same context
+ */
+int process_records(t_args *args)
+{
+    uint8_t buffer[65536];
+    uint8_t *start;
+    uint8_t *end;
+    uint8_t *next;
+    uint64_t record;
+    int pending;
+    int delim;
+    ssize_t len;
+
+    delim = (args->flags & FT_RECORD0) ? '\0' : '\n';
+    record = 0;
+    pending = 0;
+    hash_initialize(args);
+    len = read(STDIN_FILENO, buffer, sizeof(buffer));
+    while (len > 0)
+    {
+        start = buffer;
+        end = buffer + len;
+        next = memchr(start, delim, end - start);
+        while (next != NULL)
+        {
+            hash_add_bytes(args, start, next - start);
+            print_record(args, ++record);
+            hash_initialize(args);
+            start = next + 1;
+            next = memchr(start, delim, end - start);
+        }
+        // the rest of the buffer is the start of the next record
+        pending = start != end;
+        hash_add_bytes(args, start, end - start);
+        len = read(STDIN_FILENO, buffer, sizeof(buffer));
+    }
+    if (len < 0)
+        return 0;
+    // the last record doesn't need a delimiter after it
+    if (pending)
+        print_record(args, ++record);
+
+    return 1;
+}
+
 int main(int argc, char **argv)
 {
     t_args args;
@@ -261,7 +835,44 @@ int main(int argc, char **argv)
 
     read_args(argc, argv, &args);
 
-    if (args.flags & (FT_PASSTHRU | FT_STDIN))
+    if (args.flags & FT_PBKDF2)
+    {
+        if (!process_pbkdf2(&args))
+            exit(EXIT_FAILURE);
+        ft_flush();
+        return 0;
+    }
+    if (args.flags & FT_MKDB)
+    {
+        if (!process_mkdb(&args))
+            exit(EXIT_FAILURE);
+        ft_flush();
+        return 0;
+    }
+    if (args.flags & FT_DUPES)
+    {
+        if (!process_dupes(&args))
+            error_exit(args.hash, NULL, NULL);
+        ft_flush();
+        return 0;
+    }
+
+    if (args.flags & FT_TAR && args.flags & FT_STDIN)
+    {
+        if (!process_tar(&args, STDIN_FILENO, "stdin"))
+            error_exit(args.hash, "stdin", NULL);
+    }
+    else if (args.flags & FT_CHUNK && args.flags & FT_STDIN)
+    {
+        if (!process_chunks(&args, STDIN_FILENO, "stdin"))
+            error_exit(args.hash, "stdin", NULL);
+    }
+    else if (args.flags & FT_RECORDS && args.flags & FT_STDIN)
+    {
+        if (!process_records(&args))
+            error_exit(args.hash, "stdin", NULL);
+    }
+    else if (args.flags & (FT_PASSTHRU | FT_STDIN))
     {
         if (!process_stdin(&args))
             error_exit(args.hash, "stdin", NULL);
@@ -272,10 +883,28 @@ int main(int argc, char **argv)
     {
         while (args.files[0] != NULL)
         {
-            fd = open(args.files[0], O_RDONLY);
+            fd = open(args.files[0], O_RDONLY | (args.flags & FT_DIRECT ? O_DIRECT : 0));
+            // some filesystems refuse O_DIRECT, hash_direct handles plain fds
+            if (fd == -1 && errno == EINVAL && args.flags & FT_DIRECT)
+                fd = open(args.files[0], O_RDONLY);
             if (fd != -1)
             {
-                if (!process_file(&args, fd))
+                if (args.flags & FT_TAR)
+                {
+                    if (!process_tar(&args, fd, args.files[0]))
+                        error_msg(args.hash, args.files[0], NULL);
+                }
+                else if (args.flags & FT_RANGES)
+                {
+                    if (!process_ranges(&args, fd, args.files[0]))
+                        error_msg(args.hash, args.files[0], NULL);
+                }
+                else if (args.flags & FT_CHUNK)
+                {
+                    if (!process_chunks(&args, fd, args.files[0]))
+                        error_msg(args.hash, args.files[0], NULL);
+                }
+                else if (!process_file(&args, fd))
                     error_msg(args.hash, args.files[0], NULL);
                 close(fd);
             }
@@ -284,6 +913,10 @@ int main(int argc, char **argv)
             args.files = &args.files[1];
         }
     }
+    ft_flush();
+    if (args.flags & FT_MATCH)
+        matchdb_close(&args.match);
+    free(args.ranges);
 
     return 0;
 }
@@ -0,0 +1,96 @@
+#ifndef FT_SSL_H
+#define FT_SSL_H
+
+#include "md5.h"
+#include "sha256.h"
+#include "blake2.h"
+#include "blake3.h"
+#include "match.h"
+
+#define FT_MD5 1
+#define FT_SHA256 2
+#define FT_FILES 4
+#define FT_PASSTHRU 8
+#define FT_QUIET 16
+#define FT_REVERSE 32
+#define FT_STRING 64
+#define FT_STDIN 128
+#define FT_LINES 256
+#define FT_RECORD0 512
+#define FT_RECORDS (FT_LINES | FT_RECORD0)
+#define FT_BASE64 1024
+#define FT_RAW 2048
+#define FT_FIXED 4096
+#define FT_BINARY (FT_RAW | FT_FIXED)
+#define FT_CHUNK 8192
+#define FT_DUPES 16384
+#define FT_DIRECT 32768
+#define FT_MATCH 65536
+#define FT_MKDB 131072
+#define FT_BLOOM 262144
+#define FT_RANGES 524288
+#define FT_TAR 1048576
+#define FT_KERNEL 2097152
+#define FT_PBKDF2 4194304
+#define FT_BATCH 8388608
+#define FT_BLAKE2S 16777216
+#define FT_BLAKE2B 33554432
+#define FT_BLAKE3 67108864
+
+/*
+ * largest raw digest, blake2b is 64 bytes
+ */
+#define FT_DIGEST_MAX 64
+
+/*
+ * byte range of a file for --offset and --length
+ */
+typedef struct s_range
+{
+    uint64_t offset;
+    uint64_t length;
+} t_range;
+
+typedef struct s_args
+{
+    int flags;
+    char hash[8];
+    char HASH[8];
+    char *string;
+    char **files;
+    t_md5 md5;
+    t_sha256 sha;
+    t_blake2s b2s;
+    t_blake2b b2b;
+    t_blake3 b3;
+    t_matchdb match;
+    t_range *ranges;
+    int range_count;
+    char *salt;
+    uint64_t iterations;
+    uint64_t keylen;
+} t_args;
+
+void error_msg(char *prefix, char *subject, char *message);
+void error_exit(char *prefix, char *subject, char *message);
+void hash_initialize(t_args *args);
+void hash_add_bytes(t_args *args, const uint8_t *bytes, uint64_t len);
+void hash_finalize(t_args *args);
+int hash_size(t_args *args);
+int hash_digest(t_args *args, uint8_t *dst);
+void hash_string(t_args *args, char *dst);
+int hash_skip(t_args *args);
+int print_binary_at(t_args *args, char *name, char *at);
+int print_binary(t_args *args, char *name);
+void print_file(t_args *args, char *name);
+int hash_fd(t_args *args, int fd);
+int hash_direct(t_args *args, int fd);
+int hash_kernel(t_args *args, int fd);
+int process_chunks(t_args *args, int fd, char *name);
+int process_dupes(t_args *args);
+int process_mkdb(t_args *args);
+int process_ranges(t_args *args, int fd, char *name);
+int process_tar(t_args *args, int fd, char *name);
+int process_pbkdf2(t_args *args);
+
+#endif
@@ -0,0 +1,133 @@
+// splice is a linux extension
+#define _GNU_SOURCE
+
+#include "ft_ssl.h"
+#include "libft.h"
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <linux/if_alg.h>
+
+#ifndef AF_ALG
+#define AF_ALG 38
+#endif
+
+/*
+ * bytes moved per splice call
+ */
+#define KERNEL_CHUNK 65536
+
+/*
+ * open an AF_ALG hash operation socket for the selected algorithm
+ * returns -1 when the kernel doesn't offer it
+ */
+static int kernel_open(t_args *args)
+{
+    struct sockaddr_alg sa = {0};
+    int tfm;
+    int op;
+
+    // only md5 and sha256 are stored back into the context
+    if (!(args->flags & (FT_MD5 | FT_SHA256)))
+        return -1;
+    sa.salg_family = AF_ALG;
+    ft_strcpy((char *)sa.salg_type, "hash");
+    ft_strcpy((char *)sa.salg_name, (args->flags & FT_MD5) ? "md5" : "sha256");
+    tfm = socket(AF_ALG, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (tfm == -1)
+        return -1;
+    if (bind(tfm, (struct sockaddr *)&sa, sizeof(sa)) == -1)
+    {
+        close(tfm);
+        return -1;
+    }
+    op = accept4(tfm, NULL, NULL, SOCK_CLOEXEC);
+    close(tfm);
+    return op;
+}
+
+/*
+ * move everything left in fd into the hash socket
+ * file pages go fd -> pipe -> socket and never get copied to userspace
+ */
+static int kernel_splice(int fd, int op)
+{
+    int pipes[2];
+    ssize_t len;
+    ssize_t out;
+    int ret;
+
+    if (pipe(pipes) == -1)
+        return 0;
+    ret = 1;
+    len = splice(fd, NULL, pipes[1], NULL, KERNEL_CHUNK, SPLICE_F_MOVE);
+    while (len > 0 && ret)
+    {
+        while (len > 0)
+        {
+            // more data follows until the digest is read
+            out = splice(pipes[0], NULL, op, NULL, len, SPLICE_F_MOVE | SPLICE_F_MORE);
+            if (out <= 0)
+            {
+                ret = 0;
+                break;
+            }
+            len -= out;
+        }
+        if (ret)
+            len = splice(fd, NULL, pipes[1], NULL, KERNEL_CHUNK, SPLICE_F_MOVE);
+    }
+    if (len < 0)
+        ret = 0;
+    close(pipes[0]);
+    close(pipes[1]);
+    return ret;
+}
+
+/*
+ * store a raw digest in the context so it prints like a computed one
+ */
+static void kernel_store(t_args *args, const uint8_t *digest)
+{
+    int i;
+
+    for (i = 0; i < 4 && args->flags & FT_MD5; i++)
+        args->md5.abcd[i] = (uint32_t)digest[i * 4]
+            | ((uint32_t)digest[i * 4 + 1] << 8)
+            | ((uint32_t)digest[i * 4 + 2] << 16)
+            | ((uint32_t)digest[i * 4 + 3] << 24);
+    for (i = 0; i < 8 && args->flags & FT_SHA256; i++)
+        args->sha.hash[i] = ((uint32_t)digest[i * 4] << 24)
+            | ((uint32_t)digest[i * 4 + 1] << 16)
+            | ((uint32_t)digest[i * 4 + 2] << 8)
+            | (uint32_t)digest[i * 4 + 3];
+}
+
+/*
+ * hash everything left in fd with the kernel crypto api
+ * returns 1 when the digest is done and 0 when the caller should hash it
+ * itself, fd is put back where it started in that case
+ * returns -1 if part of a pipe was used up and can't be hashed again
+ */
+int hash_kernel(t_args *args, int fd)
+{
+    uint8_t digest[32];
+    ssize_t size;
+    off_t start;
+    int op;
+    int ret;
+
+    start = lseek(fd, 0, SEEK_CUR);
+    op = kernel_open(args);
+    if (op == -1)
+        return 0;
+    size = (args->flags & FT_MD5) ? 16 : 32;
+    ret = kernel_splice(fd, op) && read(op, digest, size) == size;
+    close(op);
+    if (ret)
+        kernel_store(args, digest);
+    // data already sent can only be hashed again if fd can seek back
+    else if (start == -1 || lseek(fd, start, SEEK_SET) == -1)
+        return -1;
+    return ret;
+}
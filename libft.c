@@ -1,6 +1,7 @@
 #include "libft.h"
 #include <unistd.h>
 #include <stdarg.h>
+#include <pthread.h>
 
 size_t ft_strlen(const char *s)
 {
@@ -52,6 +53,104 @@ char *ft_strcat(char *dst, const char *src)
     return (ret);
 }
 
+/*
+ * write an unsigned number as a decimal string
+ * dst must have at least 21 bytes for the digits and null
+ */
+char *ft_utoa(unsigned long long num, char *dst)
+{
+    char tmp[20];
+    int len;
+    int i;
+
+    len = 0;
+    do
+    {
+        tmp[len++] = '0' + num % 10;
+        num /= 10;
+    } while (num != 0);
+    for (i = 0; i < len; i++)
+        dst[i] = tmp[len - i - 1];
+    dst[len] = '\0';
+    return (dst);
+}
+
+/*
+ * read a decimal string into an unsigned number
+ * returns 0 if the string isn't a number or doesn't fit
+ */
+int ft_strtou(const char *s, unsigned long long *num)
+{
+    unsigned long long digit;
+
+    *num = 0;
+    if (*s == '\0')
+        return (0);
+    while (*s >= '0' && *s <= '9')
+    {
+        digit = *s - '0';
+        if (*num > (~0ULL - digit) / 10)
+            return (0);
+        *num = *num * 10 + digit;
+        s++;
+    }
+    return (*s == '\0');
+}
+
+/*
+ * stdout is buffered so a line assembled from several strings
+ * costs one write instead of one per string
+ */
+static char g_out_buffer[65536];
+static size_t g_out_size = 0;
+
+/*
+ * write everything buffered for stdout
+ */
+void ft_flush(void)
+{
+    size_t done;
+    ssize_t len;
+
+    done = 0;
+    while (done < g_out_size)
+    {
+        len = write(STDOUT_FILENO, g_out_buffer + done, g_out_size - done);
+        if (len <= 0)
+            break;
+        done += len;
+    }
+    g_out_size = 0;
+}
+
+/*
+ * write size bytes to stdout through the output buffer
+ */
+void ft_putbytes(const void *bytes, size_t size)
+{
+    const char *s;
+    ssize_t len;
+
+    s = bytes;
+    if (g_out_size + size > sizeof(g_out_buffer))
+        ft_flush();
+    // too big to be worth buffering
+    if (size >= sizeof(g_out_buffer))
+    {
+        while (size > 0)
+        {
+            len = write(STDOUT_FILENO, s, size);
+            if (len <= 0)
+                return;
+            s += len;
+            size -= len;
+        }
+        return;
+    }
+    while (size--)
+        g_out_buffer[g_out_size++] = *s++;
+}
+
 /*
  * write n number of strings to stdout
  * usage: ft_putstr(3, "abc", "xyz", "\n")
@@ -66,7 +165,7 @@ void ft_putstr(int n, ...)
     {
         s = va_arg(va, char *);
         if (s != NULL)
-            write(STDOUT_FILENO, s, ft_strlen(s));
+            ft_putbytes(s, ft_strlen(s));
     }
     va_end(va);
 }
@@ -89,3 +188,29 @@ void ft_puterr(int n, ...)
     }
     va_end(va);
 }
+
+/*
+ * run worker(data) on one thread per cpu but never more than jobs threads
+ * the calling thread is a worker too so a failed pthread_create only costs
+ * speed, returns the number of threads used once all of them are done
+ */
+int ft_parallel(void *(*worker)(void *), void *data, size_t jobs)
+{
+    pthread_t threads[64];
+    long cpus;
+    int count;
+    int i;
+
+    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    count = (cpus < 1) ? 1 : (cpus > 64) ? 64 : cpus;
+    if ((size_t)count > jobs)
+        count = (jobs > 0) ? jobs : 1;
+    for (i = 1; i < count; i++)
+        if (pthread_create(&threads[i], NULL, worker, data) != 0)
+            break;
+    count = i;
+    worker(data);
+    for (i = 1; i < count; i++)
+        pthread_join(threads[i], NULL);
+    return count;
+}
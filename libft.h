@@ -7,7 +7,12 @@ size_t ft_strlen(const char *s);
 int ft_strcmp(const char *s1, const char *s2);
 char *ft_strcpy(char *dst, const char *src);
 char *ft_strcat(char *dst, const char *src);
+char *ft_utoa(unsigned long long num, char *dst);
+int ft_strtou(const char *s, unsigned long long *num);
+void ft_flush(void);
+void ft_putbytes(const void *bytes, size_t size);
 void ft_putstr(int n, ...);
 void ft_puterr(int n, ...);
+int ft_parallel(void *(*worker)(void *), void *data, size_t jobs);
 
 #endif
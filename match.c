@@ -0,0 +1,419 @@
+#include "ft_ssl.h"
+#include "libft.h"
+#include "dynar.h"
+#include "encode.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*
+ * number of bloom filter probes and bits per digest
+ * about a 1% false positive rate
+ */
+#define MATCH_BLOOM_K 7
+#define MATCH_BLOOM_BITS 10
+
+/*
+ * longest digest list line looked at, the rest of a longer line is ignored
+ */
+#define MATCH_LINE 4096
+
+/*
+ * read 8 digest bytes as a number
+ * digests are uniformly distributed so any 8 bytes make a good hash
+ */
+static uint64_t match_load(const uint8_t *digest, int index)
+{
+    uint64_t num;
+    int i;
+
+    num = 0;
+    for (i = 7; i >= 0; i--)
+        num = (num << 8) | digest[index * 8 + i];
+    return num;
+}
+
+static int match_is_zero(const uint8_t *digest, uint64_t size)
+{
+    uint64_t i;
+
+    for (i = 0; i < size; i++)
+        if (digest[i] != 0)
+            return 0;
+    return 1;
+}
+
+/*
+ * bit number i of a digest in a bloom filter of bits bits
+ */
+static uint64_t match_bloom_bit(const uint8_t *digest, uint64_t bits, int i)
+{
+    uint64_t h2;
+
+    h2 = match_load(digest, 0);
+    h2 = ((h2 >> 32) | (h2 << 32)) | 1;
+    return (match_load(digest, 1) + i * h2) & (bits - 1);
+}
+
+/*
+ * digest size of a hash name as printed in "HASH (name) = digest" lines
+ * returns 0 for unknown names
+ */
+uint64_t matchdb_hash_size(const char *hash)
+{
+    if (ft_strcmp(hash, "MD5") == 0)
+        return 16;
+    if (ft_strcmp(hash, "SHA256") == 0 || ft_strcmp(hash, "BLAKE2S") == 0
+        || ft_strcmp(hash, "BLAKE3") == 0)
+        return 32;
+    if (ft_strcmp(hash, "BLAKE2B") == 0)
+        return 64;
+    return 0;
+}
+
+/*
+ * map a database built by mkdb
+ * returns 0 with errno set when the file can't be mapped
+ * and -1 when it isn't a valid database
+ */
+int matchdb_open(t_matchdb *db, const char *path)
+{
+    t_matchdb_header *header;
+    struct stat st;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1)
+        return 0;
+    if (fstat(fd, &st) == -1)
+    {
+        close(fd);
+        return 0;
+    }
+    if ((size_t)st.st_size < sizeof(t_matchdb_header))
+    {
+        close(fd);
+        return -1;
+    }
+    db->map_size = st.st_size;
+    db->map = mmap(NULL, db->map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (db->map == MAP_FAILED)
+        return 0;
+    header = db->map;
+    memcpy(db->hash, header->hash, 8);
+    db->hash[7] = '\0';
+    db->digest_size = header->digest_size;
+    db->slots = header->slots;
+    db->bloom_bits = header->bloom_bits;
+    db->bloom = (const uint8_t *)(header + 1);
+    db->table = db->bloom + db->bloom_bits / 8;
+    // sizes must be powers of two and add up to the file size
+    // each part is checked against the space left first so nothing overflows
+    if (memcmp(header->magic, MATCHDB_MAGIC, 8) != 0
+        || header->hash[7] != '\0'
+        || matchdb_hash_size(db->hash) != db->digest_size
+        || db->slots == 0 || (db->slots & (db->slots - 1)) != 0
+        || header->count >= db->slots
+        || (db->bloom_bits & (db->bloom_bits - 1)) != 0
+        || (db->bloom_bits != 0 && db->bloom_bits < 8)
+        || db->bloom_bits / 8 > db->map_size - sizeof(t_matchdb_header)
+        || db->slots > (db->map_size - sizeof(t_matchdb_header) - db->bloom_bits / 8)
+            / db->digest_size
+        || sizeof(t_matchdb_header) + db->bloom_bits / 8
+            + db->slots * db->digest_size != db->map_size)
+    {
+        matchdb_close(db);
+        return -1;
+    }
+    // lookups jump around the table so readahead only wastes io
+    madvise(db->map, db->map_size, MADV_RANDOM);
+    return 1;
+}
+
+/*
+ * check if a raw digest is in the database
+ * the bloom filter rejects most unknown digests without touching the table
+ */
+int matchdb_contains(t_matchdb *db, const uint8_t *digest)
+{
+    const uint8_t *slot;
+    uint64_t probes;
+    uint64_t index;
+    uint64_t bit;
+    int i;
+
+    for (i = 0; i < MATCH_BLOOM_K && db->bloom_bits != 0; i++)
+    {
+        bit = match_bloom_bit(digest, db->bloom_bits, i);
+        if (!(db->bloom[bit / 8] & (1 << (bit % 8))))
+            return 0;
+    }
+    // linear probing until the digest or an empty slot
+    // a crafted table without empty slots stops after one full pass
+    index = match_load(digest, 0) & (db->slots - 1);
+    for (probes = 0; probes < db->slots; probes++)
+    {
+        slot = db->table + index * db->digest_size;
+        if (memcmp(slot, digest, db->digest_size) == 0)
+            return 1;
+        if (match_is_zero(slot, db->digest_size))
+            return 0;
+        index = (index + 1) & (db->slots - 1);
+    }
+    return 0;
+}
+
+void matchdb_close(t_matchdb *db)
+{
+    munmap(db->map, db->map_size);
+    db->map = NULL;
+    db->map_size = 0;
+}
+
+/*
+ * find the digest on a digest list line
+ * accepts a bare digest, "digest name" and "... = digest" lines
+ * returns the digest size or 0 if the line has no digest
+ */
+static int mkdb_parse(char *line, size_t len, uint8_t *digest)
+{
+    size_t start;
+    size_t end;
+
+    // first word
+    start = 0;
+    while (start < len && (line[start] == ' ' || line[start] == '\t'))
+        start++;
+    end = start;
+    while (end < len && line[end] != ' ' && line[end] != '\t' && line[end] != '\r')
+        end++;
+    if ((end - start == 32 || end - start == 64 || end - start == 128)
+        && decode_hex(line + start, end - start, digest))
+        return (end - start) / 2;
+    // last word
+    end = len;
+    while (end > 0 && (line[end - 1] == ' ' || line[end - 1] == '\t' || line[end - 1] == '\r'))
+        end--;
+    start = end;
+    while (start > 0 && line[start - 1] != ' ' && line[start - 1] != '\t')
+        start--;
+    if ((end - start == 32 || end - start == 64 || end - start == 128)
+        && decode_hex(line + start, end - start, digest))
+        return (end - start) / 2;
+    return 0;
+}
+
+/*
+ * find the hash name of a "HASH (name) = digest" line
+ * hash is left empty for other lines and unknown names
+ */
+static void mkdb_hash(char *line, size_t len, char *hash)
+{
+    size_t i;
+
+    for (i = 0; i < len && i < 7 && line[i] != ' '; i++)
+        hash[i] = line[i];
+    hash[i] = '\0';
+    if (i + 1 >= len || line[i] != ' ' || line[i + 1] != '('
+        || matchdb_hash_size(hash) == 0)
+        hash[0] = '\0';
+}
+
+/*
+ * add one digest list line to the array of raw digests
+ * every named line must agree with the hash of the list
+ */
+static int mkdb_add(t_args *args, char *name, t_dynar *list,
+    char *line, size_t len, t_matchdb_header *header)
+{
+    uint8_t digest[FT_DIGEST_MAX];
+    char hash[8];
+    int ret;
+
+    while (len > 0 && (line[len - 1] == ' ' || line[len - 1] == '\r'))
+        len--;
+    if (len == 0)
+        return 1;
+    ret = mkdb_parse(line, len, digest);
+    if (ret == 0)
+    {
+        error_msg(args->hash, name, "line without a digest skipped");
+        return 1;
+    }
+    mkdb_hash(line, len, hash);
+    if (header->hash[0] == '\0')
+        ft_strcpy(header->hash, hash);
+    if (hash[0] != '\0' && ft_strcmp(hash, header->hash) != 0)
+    {
+        error_msg(args->hash, name, "digests of different hashes");
+        return 0;
+    }
+    if (header->digest_size == 0)
+        header->digest_size = ret;
+    if ((uint64_t)ret != header->digest_size
+        || (header->hash[0] != '\0' && (uint64_t)ret != matchdb_hash_size(header->hash)))
+    {
+        error_msg(args->hash, name, "digests of different sizes");
+        return 0;
+    }
+    // an all zero digest marks empty table slots so it can't be stored
+    if (match_is_zero(digest, ret))
+        return 1;
+    return dynar_append(list, (char *)digest, ret);
+}
+
+/*
+ * read a digest list, one digest per line
+ */
+static int mkdb_read(t_args *args, int fd, char *name, t_dynar *list,
+    t_matchdb_header *header)
+{
+    char buffer[65536];
+    char line[MATCH_LINE];
+    size_t used;
+    ssize_t len;
+    ssize_t i;
+
+    used = 0;
+    len = read(fd, buffer, sizeof(buffer));
+    while (len > 0)
+    {
+        for (i = 0; i < len; i++)
+        {
+            if (buffer[i] == '\n')
+            {
+                if (!mkdb_add(args, name, list, line, used, header))
+                    return 0;
+                used = 0;
+            }
+            else if (used < sizeof(line))
+                line[used++] = buffer[i];
+        }
+        len = read(fd, buffer, sizeof(buffer));
+    }
+    if (len < 0)
+    {
+        error_msg(args->hash, name, NULL);
+        return 0;
+    }
+    return mkdb_add(args, name, list, line, used, header);
+}
+
+/*
+ * write the header, bloom filter and table of count digests
+ * header already has the hash name and digest size
+ */
+static int mkdb_write(t_args *args, const uint8_t *digests, uint64_t count,
+    t_matchdb_header *header)
+{
+    uint64_t size;
+    uint8_t *bloom;
+    uint8_t *table;
+    uint64_t index;
+    uint64_t bit;
+    uint64_t i;
+    int k;
+
+    memcpy(header->magic, MATCHDB_MAGIC, 8);
+    size = header->digest_size;
+    header->count = 0;
+    // keep the table at most 2/3 full so probe runs stay short
+    header->slots = 1;
+    while (header->slots < count + count / 2 + 1)
+        header->slots *= 2;
+    header->bloom_bits = 0;
+    if (args->flags & FT_BLOOM)
+    {
+        header->bloom_bits = 8;
+        while (header->bloom_bits < count * MATCH_BLOOM_BITS)
+            header->bloom_bits *= 2;
+    }
+    bloom = calloc(header->bloom_bits / 8 + header->slots * size, 1);
+    if (bloom == NULL)
+        return 0;
+    table = bloom + header->bloom_bits / 8;
+    for (i = 0; i < count; i++, digests += size)
+    {
+        index = match_load(digests, 0) & (header->slots - 1);
+        while (!match_is_zero(table + index * size, size)
+            && memcmp(table + index * size, digests, size) != 0)
+            index = (index + 1) & (header->slots - 1);
+        // duplicates in the list are only stored once
+        if (!match_is_zero(table + index * size, size))
+            continue;
+        memcpy(table + index * size, digests, size);
+        header->count++;
+        for (k = 0; k < MATCH_BLOOM_K && header->bloom_bits != 0; k++)
+        {
+            bit = match_bloom_bit(digests, header->bloom_bits, k);
+            bloom[bit / 8] |= 1 << (bit % 8);
+        }
+    }
+    ft_putbytes(header, sizeof(*header));
+    ft_putbytes(bloom, header->bloom_bits / 8 + header->slots * size);
+    free(bloom);
+    return 1;
+}
+
+/*
+ * build a digest database for --match from digest lists
+ * the database is written to stdout
+ */
+int process_mkdb(t_args *args)
+{
+    t_matchdb_header header;
+    t_dynar list;
+    int ret;
+    int fd;
+    int i;
+
+    if (!dynar_init(&list))
+        return 0;
+    // --hash names the hash of lists that only have digests
+    memset(&header, 0, sizeof(header));
+    ft_strcpy(header.hash, args->HASH);
+    ret = 1;
+    if (args->flags & FT_STDIN)
+        ret = mkdb_read(args, STDIN_FILENO, "stdin", &list, &header);
+    for (i = 0; ret && args->files != NULL && args->files[i] != NULL; i++)
+    {
+        fd = open(args->files[i], O_RDONLY);
+        if (fd == -1)
+        {
+            error_msg(args->hash, args->files[i], NULL);
+            ret = 0;
+        }
+        else
+        {
+            ret = mkdb_read(args, fd, args->files[i], &list, &header);
+            close(fd);
+        }
+    }
+    if (ret && header.digest_size == 0)
+    {
+        error_msg(args->hash, NULL, "no digests found");
+        ret = 0;
+    }
+    // only md5 and blake2b can be told apart by size alone
+    if (ret && header.hash[0] == '\0' && header.digest_size == 16)
+        ft_strcpy(header.hash, "MD5");
+    if (ret && header.hash[0] == '\0' && header.digest_size == 64)
+        ft_strcpy(header.hash, "BLAKE2B");
+    if (ret && header.hash[0] == '\0')
+    {
+        error_msg(args->hash, "--hash", "needed for digest lists without hash names");
+        ret = 0;
+    }
+    if (ret && !mkdb_write(args, (uint8_t *)list.buffer,
+            list.size / header.digest_size, &header))
+    {
+        error_msg(args->hash, NULL, NULL);
+        ret = 0;
+    }
+    dynar_free(&list);
+    return ret;
+}
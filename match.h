@@ -0,0 +1,42 @@
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * known digest database layout, all fields in native byte order
+ *     header with the upper case name of the hash that made the digests
+ *     bloom filter of bloom_bits bits (bloom_bits may be 0)
+ *     hash table of slots digests, empty slots are all zero
+ */
+#define MATCHDB_MAGIC "FTSSLDB2"
+
+typedef struct s_matchdb_header
+{
+    char magic[8];
+    char hash[8];
+    uint64_t digest_size;
+    uint64_t slots;
+    uint64_t bloom_bits;
+    uint64_t count;
+} t_matchdb_header;
+
+typedef struct s_matchdb
+{
+    void *map;
+    size_t map_size;
+    char hash[8];
+    uint64_t digest_size;
+    uint64_t slots;
+    uint64_t bloom_bits;
+    const uint8_t *bloom;
+    const uint8_t *table;
+} t_matchdb;
+
+uint64_t matchdb_hash_size(const char *hash);
+int matchdb_open(t_matchdb *db, const char *path);
+int matchdb_contains(t_matchdb *db, const uint8_t *digest);
+void matchdb_close(t_matchdb *db);
+
+#endif
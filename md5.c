@@ -46,15 +46,6 @@ static uint32_t md5_get_dword(t_md5 *md5, uint32_t index)
         | (uint32_t)md5->data[index];
 }
 
-/*
- * change the endian type of a 32bit unsigned int
- */
-static uint32_t md5_swap_endian(uint32_t num)
-{
-    return (num << 24) | ((num & 0x0000ff00) << 8)
-        | ((num & 0x00ff0000) >> 8) | (num >> 24);
-}
-
 /*
  * left rotation on a 32bit unsigned int
  */
@@ -77,10 +68,10 @@ void md5_initialize(t_md5 *md5)
 }
 
 /*
- * perform the md5 calculation on a 512 byte chunk
- * assumes that the chunk is fully padded
+ * run the 64 md5 rounds on the 16 message words of a chunk
+ * and add the result to the digest
  */
-static void md5_calculate(t_md5 *md5)
+static void md5_rounds(t_md5 *md5, const uint32_t *M)
 {
     uint32_t A, B, C, D, F, g, i;
 
@@ -110,7 +101,7 @@ static void md5_calculate(t_md5 *md5)
             F = C ^ (B | (~D));
             g = (7 * i) % 16;
         }
-        F = F + A + md5_table[i] + md5_get_dword(md5, g);
+        F = F + A + md5_table[i] + M[g];
         A = D;
         D = C;
         C = B;
@@ -120,6 +111,20 @@ static void md5_calculate(t_md5 *md5)
     md5->abcd[1] += B;
     md5->abcd[2] += C;
     md5->abcd[3] += D;
+}
+
+/*
+ * perform the md5 calculation on a 512 byte chunk
+ * assumes that the chunk is fully padded
+ */
+static void md5_calculate(t_md5 *md5)
+{
+    uint32_t M[16];
+    uint32_t i;
+
+    for (i = 0; i < 16; i++)
+        M[i] = md5_get_dword(md5, i);
+    md5_rounds(md5, M);
 
     md5->bytes = 0;
 }
@@ -139,6 +144,53 @@ void md5_add_byte(t_md5 *md5, uint8_t byte)
         md5_calculate(md5);
 }
 
+/*
+ * add a buffer of bytes to a md5 data chunk
+ * same as calling md5_add_byte for every byte but without the per byte
+ * overhead when the caller already has the data in memory
+ */
+void md5_add_bytes(t_md5 *md5, const uint8_t *bytes, uint64_t len)
+{
+    uint32_t i;
+
+    md5->bits += len * 8;
+    while (len > 0)
+    {
+        // fill the chunk until it is full or the input runs out
+        i = 64 - md5->bytes;
+        if (i > len)
+            i = len;
+        len -= i;
+        while (i--)
+            md5->data[md5->bytes++] = *bytes++;
+        if (md5->bytes == 64)
+            md5_calculate(md5);
+    }
+}
+
+/*
+ * add len zero bytes to a md5 data chunk
+ * whole zero chunks skip loading the message words
+ */
+void md5_add_zeros(t_md5 *md5, uint64_t len)
+{
+    static const uint32_t zero[16];
+
+    md5->bits += len * 8;
+    // finish the partly filled chunk first
+    while (len > 0 && md5->bytes != 0)
+    {
+        md5->data[md5->bytes++] = 0;
+        len--;
+        if (md5->bytes == 64)
+            md5_calculate(md5);
+    }
+    for (; len >= 64; len -= 64)
+        md5_rounds(md5, zero);
+    while (len--)
+        md5->data[md5->bytes++] = 0;
+}
+
 /*
  * pad and process the remaining md5 data chunk
  * after calling this function bytes can no longer be added to it
@@ -180,28 +232,20 @@ void md5_finalize(t_md5 *md5)
 }
 
 /*
- * convert the md5 digest to a string
- * dst must have at least 33 bytes for the digest and null
+ * copy the md5 digest to a byte array
+ * dst must have at least 16 bytes
  */
-void md5_string(t_md5 *md5, char *dst)
+void md5_digest(t_md5 *md5, uint8_t *dst)
 {
-    char hex[] = "0123456789abcdef";
-    uint32_t num;
     int i;
 
+    // the state words are stored little-endian in the digest
     for (i = 0; i < 4; i++)
     {
-        // change the hash to big endian
-        num = md5_swap_endian(md5->abcd[i]);
-        dst[0] = hex[num >> 28];
-        dst[1] = hex[(num >> 24) & 0xf];
-        dst[2] = hex[(num >> 20) & 0xf];
-        dst[3] = hex[(num >> 16) & 0xf];
-        dst[4] = hex[(num >> 12) & 0xf];
-        dst[5] = hex[(num >> 8) & 0xf];
-        dst[6] = hex[(num >> 4) & 0xf];
-        dst[7] = hex[num & 0xf];
-        dst += 8;
+        dst[0] = md5->abcd[i] & 0xff;
+        dst[1] = (md5->abcd[i] >> 8) & 0xff;
+        dst[2] = (md5->abcd[i] >> 16) & 0xff;
+        dst[3] = md5->abcd[i] >> 24;
+        dst += 4;
     }
-    *dst = '\0';
 }
@@ -13,7 +13,9 @@ typedef struct s_md5
 
 void md5_initialize(t_md5 *md5);
 void md5_add_byte(t_md5 *md5, uint8_t byte);
+void md5_add_bytes(t_md5 *md5, const uint8_t *bytes, uint64_t len);
+void md5_add_zeros(t_md5 *md5, uint64_t len);
 void md5_finalize(t_md5 *md5);
-void md5_string(t_md5 *md5, char *dst);
+void md5_digest(t_md5 *md5, uint8_t *dst);
 
 #endif
@@ -0,0 +1,315 @@
+#include "ft_ssl.h"
+#include "libft.h"
+#include "dynar.h"
+#include "encode.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <time.h>
+
+/*
+ * longest derived key, keeps the hex output buffer on the stack
+ */
+#define PBKDF2_KEY_MAX 1024
+
+/*
+ * hmac-sha256 with the key already absorbed
+ * inner and outer hold the state after the first chunk of each hash
+ * so every hmac of a short message only costs two compressions
+ */
+typedef struct s_hmac
+{
+    t_sha256 inner;
+    t_sha256 outer;
+} t_hmac;
+
+typedef struct s_pbkdf2_job
+{
+    char *password;
+    size_t password_len;
+    char *salt;
+    size_t salt_len;
+    uint8_t *key;
+} t_pbkdf2_job;
+
+typedef struct s_pbkdf2_pool
+{
+    t_pbkdf2_job *jobs;
+    uint64_t iterations;
+    uint64_t keylen;
+    int count;
+    int next;
+} t_pbkdf2_pool;
+
+static void hmac_init(t_hmac *hmac, const uint8_t *key, size_t len)
+{
+    uint8_t block[64];
+    t_sha256 sha;
+    size_t i;
+
+    // keys longer than a chunk are hashed first
+    for (i = 0; i < 64; i++)
+        block[i] = 0;
+    if (len > 64)
+    {
+        sha256_initialize(&sha);
+        sha256_add_bytes(&sha, key, len);
+        sha256_finalize(&sha);
+        sha256_digest(&sha, block);
+    }
+    else
+        for (i = 0; i < len; i++)
+            block[i] = key[i];
+    for (i = 0; i < 64; i++)
+        block[i] ^= 0x36;
+    sha256_initialize(&hmac->inner);
+    sha256_add_bytes(&hmac->inner, block, 64);
+    // 0x36 ^ 0x5c turns the inner pad into the outer pad
+    for (i = 0; i < 64; i++)
+        block[i] ^= 0x36 ^ 0x5c;
+    sha256_initialize(&hmac->outer);
+    sha256_add_bytes(&hmac->outer, block, 64);
+}
+
+/*
+ * hmac of a message split in two parts, either part may be empty
+ */
+static void hmac_run(const t_hmac *hmac, const uint8_t *msg, size_t len,
+    const uint8_t *msg2, size_t len2, uint8_t *dst)
+{
+    t_sha256 sha;
+
+    sha = hmac->inner;
+    sha256_add_bytes(&sha, msg, len);
+    sha256_add_bytes(&sha, msg2, len2);
+    sha256_finalize(&sha);
+    sha256_digest(&sha, dst);
+    sha = hmac->outer;
+    sha256_add_bytes(&sha, dst, 32);
+    sha256_finalize(&sha);
+    sha256_digest(&sha, dst);
+}
+
+/*
+ * PBKDF2-HMAC-SHA256 from RFC8018
+ */
+static void pbkdf2_derive(t_pbkdf2_job *job, uint64_t iterations, uint64_t keylen)
+{
+    uint8_t index[4];
+    uint8_t u[32];
+    uint8_t t[32];
+    uint64_t block;
+    uint64_t done;
+    uint64_t i;
+    t_hmac hmac;
+    int j;
+
+    hmac_init(&hmac, (uint8_t *)job->password, job->password_len);
+    done = 0;
+    for (block = 1; done < keylen; block++)
+    {
+        index[0] = block >> 24;
+        index[1] = (block >> 16) & 0xff;
+        index[2] = (block >> 8) & 0xff;
+        index[3] = block & 0xff;
+        hmac_run(&hmac, (uint8_t *)job->salt, job->salt_len, index, 4, u);
+        for (j = 0; j < 32; j++)
+            t[j] = u[j];
+        // U1 and T1 are done, the other iterations are 32 byte messages
+        for (i = 1; i < iterations; i++)
+        {
+            hmac_run(&hmac, u, 32, NULL, 0, u);
+            for (j = 0; j < 32; j++)
+                t[j] ^= u[j];
+        }
+        for (j = 0; j < 32 && done < keylen; j++)
+            job->key[done++] = t[j];
+    }
+}
+
+static void *pbkdf2_worker(void *data)
+{
+    t_pbkdf2_pool *pool;
+    int i;
+
+    pool = data;
+    i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    while (i < pool->count)
+    {
+        pbkdf2_derive(&pool->jobs[i], pool->iterations, pool->keylen);
+        i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+/*
+ * read all "password<TAB>salt" lines of a batch input
+ * lines are kept in one buffer and split in place
+ */
+static int pbkdf2_read(t_args *args, int fd, char *name, t_dynar *text)
+{
+    char buffer[65536];
+    ssize_t len;
+
+    len = read(fd, buffer, sizeof(buffer));
+    while (len > 0)
+    {
+        if (!dynar_append(text, buffer, len))
+        {
+            error_msg(args->hash, NULL, NULL);
+            return 0;
+        }
+        len = read(fd, buffer, sizeof(buffer));
+    }
+    if (len < 0)
+        error_msg(args->hash, name, NULL);
+    return len == 0;
+}
+
+static int pbkdf2_split(t_args *args, t_dynar *text, t_dynar *jobs)
+{
+    t_pbkdf2_job job;
+    char *line;
+    char *end;
+    char *tab;
+
+    line = text->buffer;
+    while (line < text->buffer + text->size)
+    {
+        end = memchr(line, '\n', text->buffer + text->size - line);
+        if (end == NULL)
+            end = text->buffer + text->size;
+        tab = memchr(line, '\t', end - line);
+        if (tab == NULL && end != line)
+            error_msg(args->hash, NULL, "batch line without a tab skipped");
+        else if (tab != NULL)
+        {
+            job.password = line;
+            job.password_len = tab - line;
+            job.salt = tab + 1;
+            job.salt_len = end - tab - 1;
+            if (job.salt_len > 0 && job.salt[job.salt_len - 1] == '\r')
+                job.salt_len--;
+            if (!dynar_append(jobs, (char *)&job, sizeof(job)))
+            {
+                error_msg(args->hash, NULL, NULL);
+                return 0;
+            }
+        }
+        line = end + 1;
+    }
+    return 1;
+}
+
+/*
+ * derive a key for every line of the batch inputs and print them in order
+ * the rate is written to stderr so it doesn't mix with the keys
+ * errors are reported here
+ */
+static int pbkdf2_batch(t_args *args, t_pbkdf2_pool *pool)
+{
+    struct timespec start;
+    struct timespec end;
+    char number[21];
+    char hex[PBKDF2_KEY_MAX * 2 + 1];
+    t_dynar text;
+    t_dynar jobs;
+    uint8_t *keys;
+    double seconds;
+    int ret;
+    int fd;
+    int i;
+
+    if (!dynar_init(&text))
+    {
+        error_msg(args->hash, NULL, NULL);
+        return 0;
+    }
+    if (!dynar_init(&jobs))
+    {
+        error_msg(args->hash, NULL, NULL);
+        dynar_free(&text);
+        return 0;
+    }
+    ret = 1;
+    if (args->flags & FT_STDIN)
+        ret = pbkdf2_read(args, STDIN_FILENO, "stdin", &text);
+    for (i = 0; ret && args->files != NULL && args->files[i] != NULL; i++)
+    {
+        fd = open(args->files[i], O_RDONLY);
+        if (fd == -1)
+        {
+            error_msg(args->hash, args->files[i], NULL);
+            ret = 0;
+        }
+        else
+        {
+            ret = pbkdf2_read(args, fd, args->files[i], &text);
+            close(fd);
+        }
+    }
+    // the text buffer can move while it grows so split it afterwards
+    if (ret)
+        ret = pbkdf2_split(args, &text, &jobs);
+    pool->jobs = (t_pbkdf2_job *)jobs.buffer;
+    pool->count = jobs.size / sizeof(t_pbkdf2_job);
+    keys = NULL;
+    if (ret)
+    {
+        keys = malloc(pool->count * pool->keylen + 1);
+        ret = keys != NULL;
+        if (!ret)
+            error_msg(args->hash, NULL, NULL);
+    }
+    for (i = 0; ret && i < pool->count; i++)
+        pool->jobs[i].key = keys + i * pool->keylen;
+    if (ret)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        ft_parallel(pbkdf2_worker, pool, pool->count);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        for (i = 0; i < pool->count; i++)
+            ft_putstr(2, encode_hex(pool->jobs[i].key, pool->keylen, hex), "\n");
+        seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        ft_flush();
+        ft_puterr(3, "ft_ssl: pbkdf2: ", ft_utoa(pool->count, number), " derivations, ");
+        ft_puterr(2, ft_utoa(seconds > 0 ? pool->count / seconds : 0, number), " per second\n");
+    }
+    free(keys);
+    dynar_free(&text);
+    dynar_free(&jobs);
+    return ret;
+}
+
+/*
+ * derive a key from -s password and --salt, or from every line of a batch
+ */
+int process_pbkdf2(t_args *args)
+{
+    char hex[PBKDF2_KEY_MAX * 2 + 1];
+    uint8_t key[PBKDF2_KEY_MAX];
+    t_pbkdf2_pool pool;
+    t_pbkdf2_job job;
+
+    pool.iterations = args->iterations;
+    pool.keylen = args->keylen;
+    pool.next = 0;
+    if (args->flags & FT_BATCH)
+        return pbkdf2_batch(args, &pool);
+    job.password = args->string;
+    job.password_len = ft_strlen(args->string);
+    job.salt = args->salt;
+    job.salt_len = ft_strlen(args->salt);
+    job.key = key;
+    pbkdf2_derive(&job, pool.iterations, pool.keylen);
+    encode_hex(job.key, pool.keylen, hex);
+    // the password is a secret so only the salt names the key
+    if (!(args->flags & (FT_REVERSE | FT_QUIET)))
+        ft_putstr(6, args->HASH, " (salt \"", args->salt, "\") = ", hex, "\n");
+    else if (args->flags & FT_REVERSE && !(args->flags & FT_QUIET))
+        ft_putstr(4, hex, " salt \"", args->salt, "\"\n");
+    else
+        ft_putstr(2, hex, "\n");
+    return 1;
+}
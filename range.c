@@ -0,0 +1,138 @@
+#include "ft_ssl.h"
+#include "libft.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+
+/*
+ * one byte range of a file and the context it was hashed with
+ * every job has its own copy of args so ranges can be hashed at once
+ * errno is per thread so a failed read keeps its own copy
+ */
+typedef struct s_range_job
+{
+    t_args args;
+    t_range range;
+    uint64_t length;
+    int fd;
+    int error;
+} t_range_job;
+
+/*
+ * jobs shared by the workers, each worker takes the next unclaimed one
+ */
+typedef struct s_range_pool
+{
+    t_range_job *jobs;
+    int count;
+    int next;
+} t_range_pool;
+
+/*
+ * hash length bytes from offset with pread
+ * nothing before the offset is read and the file offset isn't used
+ */
+static void range_hash(t_range_job *job)
+{
+    uint8_t buffer[65536];
+    uint64_t offset;
+    uint64_t left;
+    ssize_t len;
+
+    hash_initialize(&job->args);
+    offset = job->range.offset;
+    left = job->range.length;
+    job->length = 0;
+    job->error = 0;
+    while (left > 0)
+    {
+        len = (left < sizeof(buffer)) ? left : sizeof(buffer);
+        len = pread(job->fd, buffer, len, offset);
+        if (len < 0)
+            job->error = errno;
+        // a range past the end of the file stops at the end
+        if (len <= 0)
+            break;
+        hash_add_bytes(&job->args, buffer, len);
+        offset += len;
+        left -= len;
+        job->length += len;
+    }
+    hash_finalize(&job->args);
+}
+
+static void *range_worker(void *data)
+{
+    t_range_pool *pool;
+    int i;
+
+    pool = data;
+    i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    while (i < pool->count)
+    {
+        range_hash(&pool->jobs[i]);
+        i = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+/*
+ * print the digest of a range in the same layout as chunk
+ */
+static void range_print(t_range_job *job, char *name)
+{
+    char digest[FT_DIGEST_MAX * 2 + 1];
+    char offset[21];
+    char length[21];
+    char label[44];
+
+    ft_utoa(job->range.offset, offset);
+    ft_utoa(job->length, length);
+    ft_strcat(ft_strcat(ft_strcpy(label, offset), "+"), length);
+    if (hash_skip(&job->args) || print_binary_at(&job->args, name, label))
+        return;
+    hash_string(&job->args, digest);
+    if (!(job->args.flags & (FT_REVERSE | FT_QUIET)))
+        ft_putstr(8, job->args.HASH, " (", name, " @ ", label, ") = ", digest, "\n");
+    else if (job->args.flags & FT_REVERSE && !(job->args.flags & FT_QUIET))
+        ft_putstr(8, digest, " ", offset, " ", length, " ", name, "\n");
+    else
+        ft_putstr(6, offset, " ", length, " ", digest, "\n");
+}
+
+/*
+ * hash every --offset/--length range of a file
+ * ranges are spread over one thread per cpu and printed in argument order
+ */
+int process_ranges(t_args *args, int fd, char *name)
+{
+    t_range_pool pool;
+    int error;
+    int i;
+
+    pool.jobs = malloc(sizeof(t_range_job) * args->range_count);
+    if (pool.jobs == NULL)
+        return 0;
+    pool.count = args->range_count;
+    pool.next = 0;
+    for (i = 0; i < pool.count; i++)
+    {
+        pool.jobs[i].args = *args;
+        pool.jobs[i].range = args->ranges[i];
+        pool.jobs[i].fd = fd;
+    }
+    ft_parallel(range_worker, &pool, pool.count);
+    error = 0;
+    for (i = 0; i < pool.count; i++)
+    {
+        if (pool.jobs[i].error == 0)
+            range_print(&pool.jobs[i], name);
+        else if (error == 0)
+            error = pool.jobs[i].error;
+    }
+    free(pool.jobs);
+    // the caller reports the error of the first failed range
+    if (error != 0)
+        errno = error;
+    return error == 0;
+}
@@ -1,5 +1,14 @@
 #include "sha256.h"
 
+/*
+ * x86 cpus with ssse3 build the message schedule with simd
+ * the choice is made at runtime, define SHA256_PORTABLE to always use C
+ */
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(SHA256_PORTABLE)
+#define SHA256_SSSE3
+#include <immintrin.h>
+#endif
+
 /*
  * sha256 constants table from RFC6234
  */
@@ -61,26 +70,15 @@ void sha256_initialize(t_sha256 *sha)
 }
 
 /*
- * perform the sha256 calculation on a 512 byte chunk
- * assumes that the chunk is fully padded
+ * run the 64 sha256 rounds with an expanded message schedule
+ * and add the result to the hash
  */
-static void sha256_calculate(t_sha256 *sha)
+static void sha256_rounds(t_sha256 *sha, const uint32_t *W)
 {
-    uint32_t W[64];
     uint32_t A, B, C, D, E, F, G, H;
     uint32_t s0, s1, t1, t2;
     uint32_t i;
 
-    for (i = 0; i < 16; i++)
-        W[i] = sha_get_dword(sha, i);
-
-    for (i = 16; i < 64; i++)
-    {
-        s0 = sha_right_rot(W[i - 15], 7) ^ sha_right_rot(W[i - 15], 18) ^ (W[i - 15] >> 3);
-        s1 = sha_right_rot(W[i - 2], 17) ^ sha_right_rot(W[i - 2], 19) ^ (W[i - 2] >> 10);
-        W[i] = W[i - 16] + s0 + W[i - 7] + s1;
-    }
-
     A = sha->hash[0];
     B = sha->hash[1];
     C = sha->hash[2];
@@ -115,6 +113,159 @@ static void sha256_calculate(t_sha256 *sha)
     sha->hash[5] += F;
     sha->hash[6] += G;
     sha->hash[7] += H;
+}
+
+/*
+ * expand the 16 words of a chunk into the 64 word message schedule
+ */
+static void sha256_schedule(t_sha256 *sha, uint32_t *W)
+{
+    uint32_t s0, s1;
+    uint32_t i;
+
+    for (i = 0; i < 16; i++)
+        W[i] = sha_get_dword(sha, i);
+
+    for (i = 16; i < 64; i++)
+    {
+        s0 = sha_right_rot(W[i - 15], 7) ^ sha_right_rot(W[i - 15], 18) ^ (W[i - 15] >> 3);
+        s1 = sha_right_rot(W[i - 2], 17) ^ sha_right_rot(W[i - 2], 19) ^ (W[i - 2] >> 10);
+        W[i] = W[i - 16] + s0 + W[i - 7] + s1;
+    }
+}
+
+#ifdef SHA256_SSSE3
+
+/*
+ * sigma functions of the message schedule on 4 words at once
+ */
+#define SHA_SIGMA0(x) _mm_xor_si128(_mm_xor_si128( \
+    _mm_or_si128(_mm_srli_epi32(x, 7), _mm_slli_epi32(x, 25)), \
+    _mm_or_si128(_mm_srli_epi32(x, 18), _mm_slli_epi32(x, 14))), \
+    _mm_srli_epi32(x, 3))
+#define SHA_SIGMA1(x) _mm_xor_si128(_mm_xor_si128( \
+    _mm_or_si128(_mm_srli_epi32(x, 17), _mm_slli_epi32(x, 15)), \
+    _mm_or_si128(_mm_srli_epi32(x, 19), _mm_slli_epi32(x, 13))), \
+    _mm_srli_epi32(x, 10))
+
+/*
+ * one sha256 round with the schedule word and constant already added
+ */
+#define SHA_ROUND(A, B, C, D, E, F, G, H, wk) \
+    do { \
+        t1 = H + (sha_right_rot(E, 6) ^ sha_right_rot(E, 11) ^ sha_right_rot(E, 25)) \
+            + (G ^ (E & (F ^ G))) + (wk); \
+        t2 = (sha_right_rot(A, 2) ^ sha_right_rot(A, 13) ^ sha_right_rot(A, 22)) \
+            + ((A & B) | (C & (A | B))); \
+        D += t1; \
+        H = t1 + t2; \
+    } while (0)
+
+/*
+ * make schedule words W[i..i+3] from X0..X3 which hold W[i-16..i-1]
+ * the result replaces X0 which is no longer needed
+ */
+#define SHA_SCHEDULE(X0, X1, X2, X3, i) \
+    do { \
+        w15 = _mm_alignr_epi8(X1, X0, 4); \
+        w7 = _mm_alignr_epi8(X3, X2, 4); \
+        t = _mm_add_epi32(_mm_add_epi32(X0, w7), SHA_SIGMA0(w15)); \
+        t = _mm_add_epi32(t, SHA_SIGMA1(_mm_srli_si128(X3, 8))); \
+        X0 = _mm_add_epi32(t, SHA_SIGMA1(_mm_slli_si128(t, 8))); \
+        _mm_storeu_si128((__m128i *)(WK + (i)), _mm_add_epi32(X0, \
+            _mm_loadu_si128((const __m128i *)(sha256_table + (i))))); \
+    } while (0)
+
+/*
+ * sha256 with the message schedule done 4 words at a time
+ * pshufb does the big-endian loads and each step makes W[i..i+3]
+ * W[i+2] and W[i+3] depend on W[i] and W[i+1] so sigma1 is done in two halves
+ * the schedule for rounds i+16.. is built while rounds i.. run
+ */
+__attribute__((target("ssse3")))
+static void sha256_calculate_ssse3(t_sha256 *sha)
+{
+    __m128i swap, X0, X1, X2, X3, w15, w7, t;
+    uint32_t WK[64];
+    uint32_t A, B, C, D, E, F, G, H;
+    uint32_t t1, t2;
+    uint32_t i;
+
+    swap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+    X0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)sha->data), swap);
+    X1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(sha->data + 16)), swap);
+    X2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(sha->data + 32)), swap);
+    X3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(sha->data + 48)), swap);
+    _mm_storeu_si128((__m128i *)WK, _mm_add_epi32(X0, _mm_loadu_si128((const __m128i *)sha256_table)));
+    _mm_storeu_si128((__m128i *)(WK + 4), _mm_add_epi32(X1, _mm_loadu_si128((const __m128i *)(sha256_table + 4))));
+    _mm_storeu_si128((__m128i *)(WK + 8), _mm_add_epi32(X2, _mm_loadu_si128((const __m128i *)(sha256_table + 8))));
+    _mm_storeu_si128((__m128i *)(WK + 12), _mm_add_epi32(X3, _mm_loadu_si128((const __m128i *)(sha256_table + 12))));
+
+    A = sha->hash[0];
+    B = sha->hash[1];
+    C = sha->hash[2];
+    D = sha->hash[3];
+    E = sha->hash[4];
+    F = sha->hash[5];
+    G = sha->hash[6];
+    H = sha->hash[7];
+
+    for (i = 0; i < 64; i += 8)
+    {
+        if (i < 48)
+        {
+            SHA_SCHEDULE(X0, X1, X2, X3, i + 16);
+            SHA_SCHEDULE(X1, X2, X3, X0, i + 20);
+        }
+        SHA_ROUND(A, B, C, D, E, F, G, H, WK[i]);
+        SHA_ROUND(H, A, B, C, D, E, F, G, WK[i + 1]);
+        SHA_ROUND(G, H, A, B, C, D, E, F, WK[i + 2]);
+        SHA_ROUND(F, G, H, A, B, C, D, E, WK[i + 3]);
+        SHA_ROUND(E, F, G, H, A, B, C, D, WK[i + 4]);
+        SHA_ROUND(D, E, F, G, H, A, B, C, WK[i + 5]);
+        SHA_ROUND(C, D, E, F, G, H, A, B, WK[i + 6]);
+        SHA_ROUND(B, C, D, E, F, G, H, A, WK[i + 7]);
+        if (i < 48)
+        {
+            t = X0;
+            X0 = X2;
+            X2 = t;
+            t = X1;
+            X1 = X3;
+            X3 = t;
+        }
+    }
+
+    sha->hash[0] += A;
+    sha->hash[1] += B;
+    sha->hash[2] += C;
+    sha->hash[3] += D;
+    sha->hash[4] += E;
+    sha->hash[5] += F;
+    sha->hash[6] += G;
+    sha->hash[7] += H;
+}
+
+#endif
+
+/*
+ * perform the sha256 calculation on a 512 byte chunk
+ * assumes that the chunk is fully padded
+ */
+static void sha256_calculate(t_sha256 *sha)
+{
+    uint32_t W[64];
+
+#ifdef SHA256_SSSE3
+    if (__builtin_cpu_supports("ssse3"))
+    {
+        sha256_calculate_ssse3(sha);
+        sha->bytes = 0;
+        return;
+    }
+#endif
+    sha256_schedule(sha, W);
+    sha256_rounds(sha, W);
 
     sha->bytes = 0;
 }
@@ -134,6 +285,54 @@ void sha256_add_byte(t_sha256 *sha, uint8_t byte)
         sha256_calculate(sha);
 }
 
+/*
+ * add a buffer of bytes to a sha256 data chunk
+ * same as calling sha256_add_byte for every byte but without the per byte
+ * overhead when the caller already has the data in memory
+ */
+void sha256_add_bytes(t_sha256 *sha, const uint8_t *bytes, uint64_t len)
+{
+    uint32_t i;
+
+    sha->bits += len * 8;
+    while (len > 0)
+    {
+        // fill the chunk until it is full or the input runs out
+        i = 64 - sha->bytes;
+        if (i > len)
+            i = len;
+        len -= i;
+        while (i--)
+            sha->data[sha->bytes++] = *bytes++;
+        if (sha->bytes == 64)
+            sha256_calculate(sha);
+    }
+}
+
+/*
+ * add len zero bytes to a sha256 data chunk
+ * the message schedule of an all zero chunk is all zero
+ * so whole zero chunks skip loading and expanding it
+ */
+void sha256_add_zeros(t_sha256 *sha, uint64_t len)
+{
+    static const uint32_t zero[64];
+
+    sha->bits += len * 8;
+    // finish the partly filled chunk first
+    while (len > 0 && sha->bytes != 0)
+    {
+        sha->data[sha->bytes++] = 0;
+        len--;
+        if (sha->bytes == 64)
+            sha256_calculate(sha);
+    }
+    for (; len >= 64; len -= 64)
+        sha256_rounds(sha, zero);
+    while (len--)
+        sha->data[sha->bytes++] = 0;
+}
+
 /*
  * pad and process the remaining sha256 data chunk
  * after calling this function bytes can no longer be added to it
@@ -175,25 +374,20 @@ void sha256_finalize(t_sha256 *sha)
 }
 
 /*
- * convert the sha256 digest to a string
- * dst must have at least 65 bytes for the digest and null
+ * copy the sha256 digest to a byte array
+ * dst must have at least 32 bytes
  */
-void sha256_string(t_sha256 *sha, char *dst)
+void sha256_digest(t_sha256 *sha, uint8_t *dst)
 {
-    char hex[] = "0123456789abcdef";
     int i;
 
+    // the state words are stored big-endian in the digest
     for (i = 0; i < 8; i++)
     {
-        dst[0] = hex[sha->hash[i] >> 28];
-        dst[1] = hex[(sha->hash[i] >> 24) & 0xf];
-        dst[2] = hex[(sha->hash[i] >> 20) & 0xf];
-        dst[3] = hex[(sha->hash[i] >> 16) & 0xf];
-        dst[4] = hex[(sha->hash[i] >> 12) & 0xf];
-        dst[5] = hex[(sha->hash[i] >> 8) & 0xf];
-        dst[6] = hex[(sha->hash[i] >> 4) & 0xf];
-        dst[7] = hex[sha->hash[i] & 0xf];
-        dst += 8;
+        dst[0] = sha->hash[i] >> 24;
+        dst[1] = (sha->hash[i] >> 16) & 0xff;
+        dst[2] = (sha->hash[i] >> 8) & 0xff;
+        dst[3] = sha->hash[i] & 0xff;
+        dst += 4;
     }
-    *dst = '\0';
 }
@@ -13,7 +13,9 @@ typedef struct s_sha256
 
 void sha256_initialize(t_sha256 *sha);
 void sha256_add_byte(t_sha256 *sha, uint8_t byte);
+void sha256_add_bytes(t_sha256 *sha, const uint8_t *bytes, uint64_t len);
+void sha256_add_zeros(t_sha256 *sha, uint64_t len);
 void sha256_finalize(t_sha256 *sha);
-void sha256_string(t_sha256 *sha, char *dst);
+void sha256_digest(t_sha256 *sha, uint8_t *dst);
 
 #endif
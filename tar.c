@@ -0,0 +1,340 @@
+#include "ft_ssl.h"
+#include "libft.h"
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * tar archives are made of 512 byte blocks
+ * a header block is followed by the member data padded to a whole block
+ */
+#define TAR_BLOCK 512
+
+/*
+ * largest pax or gnu long name header kept in memory
+ */
+#define TAR_META_MAX 1048576
+
+/*
+ * ustar header field offsets and sizes
+ */
+#define TAR_NAME 0
+#define TAR_SIZE 124
+#define TAR_CHKSUM 148
+#define TAR_TYPE 156
+#define TAR_MAGIC 257
+#define TAR_PREFIX 345
+
+typedef struct s_tar
+{
+    int fd;
+    char *path;
+    uint64_t size;
+    int has_size;
+    char *error;
+} t_tar;
+
+/*
+ * read exactly len bytes unless the input ends first
+ * returns the number of bytes read or -1 on error
+ */
+static ssize_t tar_read(int fd, uint8_t *buffer, size_t len)
+{
+    size_t done;
+    ssize_t ret;
+
+    done = 0;
+    while (done < len)
+    {
+        ret = read(fd, buffer + done, len - done);
+        if (ret < 0)
+            return -1;
+        if (ret == 0)
+            break;
+        done += ret;
+    }
+    return done;
+}
+
+/*
+ * read len bytes that the archive says are there
+ * running out early is a broken archive rather than a read error
+ */
+static int tar_need(t_tar *tar, uint8_t *buffer, size_t len)
+{
+    ssize_t ret;
+
+    ret = tar_read(tar->fd, buffer, len);
+    if (ret >= 0 && (size_t)ret != len)
+        tar->error = "unexpected end of archive";
+    return ret >= 0 && (size_t)ret == len;
+}
+
+/*
+ * read a numeric header field
+ * fields are octal text or gnu base-256 when the high bit is set
+ */
+static uint64_t tar_number(const uint8_t *field, size_t len)
+{
+    uint64_t num;
+    size_t i;
+
+    num = 0;
+    if (field[0] & 0x80)
+    {
+        num = field[0] & 0x7f;
+        for (i = 1; i < len; i++)
+            num = (num << 8) | field[i];
+        return num;
+    }
+    i = 0;
+    while (i < len && field[i] == ' ')
+        i++;
+    while (i < len && field[i] >= '0' && field[i] <= '7')
+        num = num * 8 + (field[i++] - '0');
+    return num;
+}
+
+/*
+ * the checksum is the sum of the header bytes with the checksum field as spaces
+ */
+static int tar_checksum(const uint8_t *header)
+{
+    uint64_t sum;
+    int i;
+
+    sum = 0;
+    for (i = 0; i < TAR_BLOCK; i++)
+    {
+        if (i >= TAR_CHKSUM && i < TAR_CHKSUM + 8)
+            sum += ' ';
+        else
+            sum += header[i];
+    }
+    return sum == tar_number(header + TAR_CHKSUM, 8);
+}
+
+/*
+ * hash or skip size bytes of member data and the padding after it
+ * data is streamed through the read buffer so memory use doesn't depend on size
+ */
+static int tar_data(t_args *args, t_tar *tar, uint64_t size, int hash)
+{
+    uint8_t buffer[65536];
+    uint64_t left;
+    ssize_t len;
+
+    left = size + (TAR_BLOCK - size % TAR_BLOCK) % TAR_BLOCK;
+    while (left > 0)
+    {
+        len = left < sizeof(buffer) ? left : sizeof(buffer);
+        if (!tar_need(tar, buffer, len))
+            return 0;
+        if (hash && size > 0)
+            hash_add_bytes(args, buffer, (uint64_t)len < size ? (uint64_t)len : size);
+        size -= (uint64_t)len < size ? (uint64_t)len : size;
+        left -= len;
+    }
+    return 1;
+}
+
+/*
+ * read a pax or gnu long name header into memory
+ */
+static char *tar_meta(t_tar *tar, uint64_t size)
+{
+    uint64_t blocks;
+    char *meta;
+
+    if (size > TAR_META_MAX)
+    {
+        tar->error = "extended header too large";
+        return NULL;
+    }
+    blocks = (size + TAR_BLOCK - 1) / TAR_BLOCK * TAR_BLOCK;
+    meta = malloc(blocks + 1);
+    if (meta == NULL)
+        return NULL;
+    if (!tar_need(tar, (uint8_t *)meta, blocks))
+    {
+        free(meta);
+        return NULL;
+    }
+    meta[size] = '\0';
+    return meta;
+}
+
+/*
+ * take the path and size out of pax records "<len> <key>=<value>\n"
+ */
+static int tar_pax(t_tar *tar, char *meta, uint64_t size)
+{
+    unsigned long long len;
+    uint64_t pos;
+    char *key;
+    char *end;
+
+    pos = 0;
+    while (pos < size)
+    {
+        len = 0;
+        key = meta + pos;
+        while (*key >= '0' && *key <= '9')
+            len = len * 10 + (*key++ - '0');
+        if (*key != ' ' || len == 0 || len > size - pos)
+            return 0;
+        key++;
+        end = meta + pos + len - 1;
+        *end = '\0';
+        if (strncmp(key, "path=", 5) == 0)
+        {
+            free(tar->path);
+            tar->path = malloc(ft_strlen(key + 5) + 1);
+            if (tar->path == NULL)
+                return 0;
+            ft_strcpy(tar->path, key + 5);
+        }
+        else if (strncmp(key, "size=", 5) == 0
+            && ft_strtou(key + 5, &len))
+        {
+            tar->size = len;
+            tar->has_size = 1;
+        }
+        pos = end - meta + 1;
+    }
+    return 1;
+}
+
+/*
+ * build the member path from the ustar prefix and name fields
+ */
+static char *tar_path(const uint8_t *header)
+{
+    char *path;
+    size_t prefix;
+    size_t name;
+
+    prefix = strnlen((const char *)header + TAR_PREFIX, 155);
+    name = strnlen((const char *)header + TAR_NAME, 100);
+    // only ustar headers have a prefix field
+    if (memcmp(header + TAR_MAGIC, "ustar", 5) != 0)
+        prefix = 0;
+    path = malloc(prefix + name + 2);
+    if (path == NULL)
+        return NULL;
+    memcpy(path, header + TAR_PREFIX, prefix);
+    if (prefix > 0)
+        path[prefix++] = '/';
+    memcpy(path + prefix, header + TAR_NAME, name);
+    path[prefix + name] = '\0';
+    return path;
+}
+
+/*
+ * handle one header block and the data after it
+ * returns 0 on error
+ */
+static int tar_member(t_args *args, t_tar *tar, const uint8_t *header)
+{
+    uint64_t size;
+    char *meta;
+    char *path;
+    int ret;
+
+    size = tar_number(header + TAR_SIZE, 12);
+    // extended headers describe the next member
+    if (header[TAR_TYPE] == 'x' || header[TAR_TYPE] == 'L')
+    {
+        meta = tar_meta(tar, size);
+        if (meta == NULL)
+            return 0;
+        // a gnu long name header is just the name
+        if (header[TAR_TYPE] == 'L')
+        {
+            free(tar->path);
+            tar->path = meta;
+            return 1;
+        }
+        ret = tar_pax(tar, meta, size);
+        if (!ret)
+            tar->error = "invalid pax header";
+        free(meta);
+        return ret;
+    }
+    if (tar->has_size)
+        size = tar->size;
+    path = tar->path;
+    tar->path = NULL;
+    tar->has_size = 0;
+    if (path == NULL)
+        path = tar_path(header);
+    if (path == NULL)
+        return 0;
+    // only regular files have contents worth a digest
+    ret = header[TAR_TYPE] == '0' || header[TAR_TYPE] == '\0' || header[TAR_TYPE] == '7';
+    if (ret)
+        hash_initialize(args);
+    if (!tar_data(args, tar, size, ret))
+    {
+        free(path);
+        return 0;
+    }
+    if (ret)
+    {
+        hash_finalize(args);
+        print_file(args, path);
+    }
+    free(path);
+    return 1;
+}
+
+/*
+ * print a digest for every file in a tar archive without extracting it
+ * the archive is read once from start to end so it can come from a pipe
+ * returns 0 on read errors, broken archives are reported here
+ */
+int process_tar(t_args *args, int fd, char *name)
+{
+    uint8_t header[TAR_BLOCK];
+    t_tar tar;
+    ssize_t len;
+    int ret;
+    int i;
+
+    tar.fd = fd;
+    tar.path = NULL;
+    tar.has_size = 0;
+    tar.error = NULL;
+    ret = 1;
+    while (ret)
+    {
+        len = tar_read(fd, header, TAR_BLOCK);
+        // a missing end of archive marker is accepted like tar does
+        if (len == 0)
+            break;
+        if (len < 0)
+            ret = 0;
+        else if (len != TAR_BLOCK)
+            tar.error = "unexpected end of archive";
+        if (len != TAR_BLOCK)
+            break;
+        // an all zero block marks the end of the archive
+        for (i = 0; i < TAR_BLOCK && header[i] == 0; i++)
+            ;
+        if (i == TAR_BLOCK)
+            break;
+        if (!tar_checksum(header))
+            tar.error = "invalid tar header";
+        else
+            ret = tar_member(args, &tar, header);
+        if (tar.error != NULL)
+            break;
+    }
+    free(tar.path);
+    if (tar.error != NULL)
+    {
+        error_msg(args->hash, name, tar.error);
+        return 1;
+    }
+    return ret;
+}
@@ -0,0 +1,41 @@
+file1=blake2s_test_1.txt
+file2=blake2s_test_2.txt
+random=blake2s_random.txt
+
+if [ -f "../ft_ssl" ]
+then
+    echo "Found ft_ssl"
+else
+    echo "Missing ft_ssl"
+    exit
+fi
+
+if ! openssl dgst -blake2s256 < /dev/null > /dev/null 2>&1
+then
+    echo "Missing openssl with blake2s256"
+    exit
+fi
+
+gcc randstr.c -o randstr
+
+rm "$file1" "$file2" 2>/dev/null
+
+for i in $(seq 0 1000)
+do
+    echo Testing $i random character string
+    str=`./randstr $i`
+    printf "$str" | openssl dgst -blake2s256 -r | cut -d " " -f 1 >> "$file1"
+    ../ft_ssl blake2s -q -s "$str" >> "$file2"
+done
+
+for i in $(seq 1001 2000)
+do
+    echo Testing $i byte random character file
+    head -c $i < /dev/random > "$random"
+    cat "$random" | openssl dgst -blake2s256 -r | cut -d " " -f 1 >> "$file1"
+    ../ft_ssl blake2s -q "$random" >> "$file2"
+done
+
+diff -s "$file1" "$file2"
+
+rm "$file1" "$file2" "$random" randstr
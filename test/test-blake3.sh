@@ -0,0 +1,50 @@
+file1=blake3_test_1.txt
+file2=blake3_test_2.txt
+random=blake3_random.txt
+
+if [ -f "../ft_ssl" ]
+then
+    echo "Found ft_ssl"
+else
+    echo "Missing ft_ssl"
+    exit
+fi
+
+if ! command -v b3sum > /dev/null
+then
+    echo "Missing b3sum"
+    exit
+fi
+
+gcc randstr.c -o randstr
+
+rm "$file1" "$file2" 2>/dev/null
+
+for i in $(seq 0 1000)
+do
+    echo Testing $i random character string
+    str=`./randstr $i`
+    printf "$str" | b3sum --no-names | cut -d " " -f 1 >> "$file1"
+    ../ft_ssl blake3 -q -s "$str" >> "$file2"
+done
+
+for i in $(seq 1001 2000)
+do
+    echo Testing $i byte random character file
+    head -c $i < /dev/random > "$random"
+    cat "$random" | b3sum --no-names | cut -d " " -f 1 >> "$file1"
+    ../ft_ssl blake3 -q "$random" >> "$file2"
+done
+
+# large files use the simd, segment and cpu split paths
+for i in 1048576 1048577 2097152 2097153 3145729 5000000 16777217
+do
+    echo Testing $i byte random file
+    head -c $i < /dev/urandom > "$random"
+    b3sum --no-names "$random" >> "$file1"
+    ../ft_ssl blake3 -q "$random" >> "$file2"
+done
+
+diff -s "$file1" "$file2"
+
+rm "$file1" "$file2" "$random" randstr
@@ -0,0 +1,68 @@
+file1=chunk_test_1.txt
+file2=chunk_test_2.txt
+random=chunk_random.txt
+zeros=chunk_zeros.txt
+spans=chunk_spans.txt
+
+if [ -f "../ft_ssl" ]
+then
+    echo "Found ft_ssl"
+else
+    echo "Missing ft_ssl"
+    exit
+fi
+
+rm "$file1" "$file2" 2>/dev/null
+
+# the spans must follow each other from offset 0 to the end of the file
+# and every chunk sum must be the sum of those bytes of the file
+check()
+{
+    ../ft_ssl chunk -q "$1" > "$spans"
+    awk -v size=$(stat -c %s "$1") -v name="$1" '
+        $1 != next_offset { print name ": gap or overlap at " $1 }
+        { next_offset = $1 + $2 }
+        END { if (next_offset + 0 != size) print name ": spans end at " next_offset + 0 " not " size }
+    ' "$spans" >> "$file2"
+    while read start length digest
+    do
+        echo "$start $length $digest" >> "$file1"
+        sum=$(dd if="$1" bs=65536 skip=$start count=$length iflag=skip_bytes,count_bytes \
+            2>/dev/null | sha256sum | cut -d " " -f 1)
+        echo "$start $length $sum" >> "$file2"
+    done < "$spans"
+    # stdin is scanned in the same batches as files
+    cat "$spans" >> "$file1"
+    cat "$1" | ../ft_ssl chunk -q >> "$file2"
+}
+
+# the binary digest, 32bit big-endian name length and "name @ offset+length"
+record()
+{
+    ../ft_ssl chunk -r "$@" | while read digest start length name
+    do
+        label="$name @ $start+$length"
+        printf "%s%08x" "$digest" "${#label}" | xxd -r -p
+        printf "%s" "$label"
+    done
+}
+
+for i in 0 1 2047 2048 100000 5000000 9000000
+do
+    echo Testing $i byte random file
+    head -c $i < /dev/urandom > "$random"
+    check "$random"
+done
+
+# zeros never match the masks so every chunk is cut at the largest size
+echo Testing 12000000 byte file of zeros
+head -c 12000000 < /dev/zero > "$zeros"
+check "$zeros"
+
+echo Testing record output with several inputs
+record "$random" "$zeros" >> "$file1"
+../ft_ssl chunk --format record "$random" "$zeros" >> "$file2"
+
+cmp "$file1" "$file2" && echo "Files $file1 and $file2 are identical"
+
+rm "$file1" "$file2" "$random" "$zeros" "$spans"
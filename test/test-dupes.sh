@@ -0,0 +1,62 @@
+file1=dupes_test_1.txt
+file2=dupes_test_2.txt
+dir=dupes_directory
+link=dupes_link
+
+if [ -f "../ft_ssl" ]
+then
+    echo "Found ft_ssl"
+else
+    echo "Missing ft_ssl"
+    exit
+fi
+
+rm -rf "$file1" "$file2" "$dir" "$link" 2>/dev/null
+mkdir "$dir" "$link"
+
+# print "digest path" like dupes -r for each file
+expected()
+{
+    for f in "$@"
+    do
+        echo "$(sha256sum < "$f" | cut -d " " -f 1) $f"
+    done
+}
+
+# large identical files, read in full after the partial digests match
+head -c 100000 < /dev/urandom > "$dir/big1"
+cp "$dir/big1" "$dir/big2"
+# a hard link is the same file and is only listed once
+ln "$dir/big1" "$link/big3"
+# small identical files, the partial digest covers them
+head -c 1000 < /dev/urandom > "$dir/small1"
+cp "$dir/small1" "$dir/small2"
+# same size with different contents
+head -c 1000 < /dev/urandom > "$dir/size1"
+head -c 1000 < /dev/urandom > "$dir/size2"
+# same first and last 4096 bytes with a different middle
+head -c 4096 < /dev/urandom > edge_start
+head -c 4096 < /dev/urandom > edge_end
+{ cat edge_start; head -c 5000 < /dev/urandom; cat edge_end; } > "$dir/middle1"
+{ cat edge_start; head -c 5000 < /dev/urandom; cat edge_end; } > "$dir/middle2"
+rm edge_start edge_end
+
+echo Testing groups of a directory given twice and a hard link
+expected "$dir/big1" "$dir/big2" "$dir/small1" "$dir/small2" | sort >> "$file1"
+../ft_ssl dupes -r "$dir" "$dir" "$link" | grep -v "^$" | sort >> "$file2"
+
+echo Testing the number of groups
+echo 2 >> "$file1"
+../ft_ssl dupes -q "$dir" "$link" | grep -c "^$" | awk '{ print $1 + 1 }' >> "$file2"
+
+# files of a group are printed in the order they were given and of two
+# names of one file the first is kept
+echo Testing the order of files in a group
+printf "%s\n" "$dir/small2" "$dir/small1" >> "$file1"
+../ft_ssl dupes -q "$dir/small2" "$dir/size1" "$dir/small1" >> "$file2"
+printf "%s\n" "$dir/big2" "$link/big3" >> "$file1"
+../ft_ssl dupes -q "$dir/big2" "$link/big3" "$dir/big1" >> "$file2"
+
+diff -s "$file1" "$file2"
+
+rm -rf "$file1" "$file2" "$dir" "$link"
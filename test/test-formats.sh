@@ -0,0 +1,58 @@
+file1=formats_test_1.txt
+file2=formats_test_2.txt
+random=formats_random.txt
+dir=formats_directory_with_a_long_name_so_record_names_need_more_than_one_length_byte
+
+if [ -f "../ft_ssl" ]
+then
+    echo "Found ft_ssl"
+else
+    echo "Missing ft_ssl"
+    exit
+fi
+
+rm -rf "$file1" "$file2" "$dir" 2>/dev/null
+
+# a name longer than 255 bytes checks every byte of the length prefix
+long="$dir/$dir/$dir/$dir"
+mkdir -p "$long"
+long="$long/$random"
+
+# the 32bit big-endian length prefix of --format record
+length()
+{
+    printf "%08x" "${#1}" | xxd -r -p
+}
+
+for i in 0 1 55 64 1000 70000
+do
+    echo Testing $i byte random file
+    head -c $i < /dev/urandom > "$random"
+    cp "$random" "$long"
+    for pair in md5:md5 sha256:sha256 blake2s:blake2s256 blake2b:blake2b512
+    do
+        hash=${pair%%:*}
+        dgst=${pair#*:}
+        openssl dgst -$dgst -binary < "$random" | base64 -w 0 >> "$file1"
+        echo >> "$file1"
+        ../ft_ssl $hash -q --format base64 "$random" >> "$file2"
+        openssl dgst -$dgst -binary < "$random" >> "$file1"
+        openssl dgst -$dgst -binary < "$long" >> "$file1"
+        ../ft_ssl $hash --format raw "$random" "$long" >> "$file2"
+        openssl dgst -$dgst -binary < "$random" >> "$file1"
+        length "$random" >> "$file1"
+        printf "%s" "$random" >> "$file1"
+        openssl dgst -$dgst -binary < "$long" >> "$file1"
+        length "$long" >> "$file1"
+        printf "%s" "$long" >> "$file1"
+        ../ft_ssl $hash --format record "$random" "$long" >> "$file2"
+        openssl dgst -$dgst -binary < "$random" >> "$file1"
+        length "stdin" >> "$file1"
+        printf "stdin" >> "$file1"
+        cat "$random" | ../ft_ssl $hash --format record >> "$file2"
+    done
+done
+
+cmp "$file1" "$file2" && echo "Files $file1 and $file2 are identical"
+
+rm -rf "$file1" "$file2" "$random" "$dir"
@@ -0,0 +1,57 @@
+file1=pbkdf2_test_1.txt
+file2=pbkdf2_test_2.txt
+batch1=pbkdf2_batch_1.txt
+batch2=pbkdf2_batch_2.txt
+
+if [ -f "../ft_ssl" ]
+then
+    echo "Found ft_ssl"
+else
+    echo "Missing ft_ssl"
+    exit
+fi
+
+rm "$file1" "$file2" 2>/dev/null
+
+# PBKDF2-HMAC-SHA256 vectors from RFC 7914 section 11 and the
+# RFC 6070 inputs with sha256
+echo Testing known vectors
+while read password salt iterations keylen key
+do
+    echo "$key" >> "$file1"
+    ../ft_ssl pbkdf2 -q -s "$password" --salt "$salt" --iter $iterations \
+        --keylen $keylen >> "$file2"
+done <<'EOF'
+passwd salt 1 64 55ac046e56e3089fec1691c22544b605f94185216dde0465e68b9d57c20dacbc49ca9cccf179b645991664b39d77ef317c71b845b1e30bd509112041d3a19783
+Password NaCl 80000 64 4ddcd8f60b98be21830cee5ef22701f9641a4418d04c0414aeff08876b34ab56a1d425a1225833549adb841b51c9b3176a272bdebba1d078478f62b397f33c8d
+password salt 1 32 120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b
+password salt 2 32 ae4d0c95af6b46d32d0adff928f06dd02a303f8ef3c251dfd6e2d85a95474c43
+password salt 4096 32 c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134a
+password salt 4096 40 c5e478d59288c841aa530db6845c4c8d962893a001ce4e11a4963873aa98134af7ad98c1b458ce3f
+passwordPASSWORDpassword saltSALTsaltSALTsaltSALTsaltSALTsalt 4096 40 348c89dbcbd32b2f32d814b8116e84cf2b17347ebc1800181c4e2a1fb8dd53e1c635518c7dac47e9
+EOF
+
+# the password must not be printed
+echo Testing the default output
+echo 'PBKDF2 (salt "salt") = 120fb6cffcf8b32c43e7225256c4f837a86548c92ccc35480805987cb70be17b' >> "$file1"
+../ft_ssl pbkdf2 -s password --salt salt --iter 1 >> "$file2"
+
+# passwords and salts of every length around the sha256 block size
+echo Testing a batch against python hashlib
+for i in $(seq 0 150)
+do
+    printf "%s\t%s\n" "$(head -c $i < /dev/urandom | base64 -w 0 | head -c $i)" \
+        "$(head -c $((150 - i)) < /dev/urandom | base64 -w 0 | head -c $((150 - i)))"
+done > "$batch1"
+printf "last\tline without newline" > "$batch2"
+cat "$batch1" "$batch2" | python3 -c '
+import hashlib, sys
+for line in sys.stdin.buffer.read().split(b"\n"):
+    password, salt = line.split(b"\t")
+    print(hashlib.pbkdf2_hmac("sha256", password, salt, 1000, 48).hex())
+' >> "$file1"
+../ft_ssl pbkdf2 --batch --iter 1000 --keylen 48 "$batch1" "$batch2" 2>/dev/null >> "$file2"
+
+diff -s "$file1" "$file2"
+
+rm "$file1" "$file2" "$batch1" "$batch2"
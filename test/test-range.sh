@@ -0,0 +1,65 @@
+file1=range_test_1.txt
+file2=range_test_2.txt
+random=range_random.txt
+size=1000003
+
+if [ -f "../ft_ssl" ]
+then
+    echo "Found ft_ssl"
+else
+    echo "Missing ft_ssl"
+    exit
+fi
+
+rm "$file1" "$file2" 2>/dev/null
+
+head -c $size < /dev/urandom > "$random"
+
+# print "offset length digest" like -q for a range, the length is cut at
+# the end of the file
+expected()
+{
+    length=$2
+    if [ $1 -ge $size ]
+    then
+        length=0
+    elif [ $(($1 + $2)) -gt $size ]
+    then
+        length=$(($size - $1))
+    fi
+    sum=$(tail -c +$(($1 + 1)) "$random" | head -c $length | sha256sum | cut -d " " -f 1)
+    echo "$1 $length $sum"
+}
+
+for range in "0 0" "0 1" "0 $size" "1 65536" "65535 65537" "123457 400009" \
+    "999999 4" "999999 100" "$size 10" "2000000 10"
+do
+    echo Testing range $range
+    set -- $range
+    expected $1 $2 >> "$file1"
+    ../ft_ssl sha256 -q --offset $1 --length $2 "$random" >> "$file2"
+done
+
+echo Testing a range from an offset to the end
+expected 777 $size >> "$file1"
+../ft_ssl sha256 -q --offset 777 "$random" >> "$file2"
+
+echo Testing a length without an offset
+expected 0 4242 >> "$file1"
+../ft_ssl sha256 -q --length 4242 "$random" >> "$file2"
+
+# ranges are hashed at once but printed in argument order
+echo Testing several ranges in one call
+args=""
+for i in $(seq 0 20)
+do
+    offset=$((($i * 104729) % ($size + 5000)))
+    length=$((($i * 7919) % 300000))
+    expected $offset $length >> "$file1"
+    args="$args --offset $offset --length $length"
+done
+../ft_ssl sha256 -q $args "$random" >> "$file2"
+
+diff -s "$file1" "$file2"
+
+rm "$file1" "$file2" "$random"
@@ -0,0 +1,72 @@
+file1=records_test_1.txt
+file2=records_test_2.txt
+input=records_input.txt
+
+if [ -f "../ft_ssl" ]
+then
+    echo "Found ft_ssl"
+else
+    echo "Missing ft_ssl"
+    exit
+fi
+
+rm "$file1" "$file2" 2>/dev/null
+
+# print the sum of every record of $input, the last one may miss its delimiter
+expected()
+{
+    while IFS= read -r -d "$2" rec || [ -n "$rec" ]
+    do
+        printf "%s" "$rec" | $1 | cut -d " " -f 1
+    done < "$input"
+}
+
+# check one input in line and NUL record mode with both hashes
+check()
+{
+    for hash in md5 sha256
+    do
+        expected ${hash}sum $'\n' >> "$file1"
+        ../ft_ssl $hash -q --per-line < "$input" >> "$file2"
+        expected ${hash}sum $'\n' >> "$file1"
+        cat "$input" | ../ft_ssl $hash -q --per-line >> "$file2"
+        tr '\n' '\0' < "$input" > "$input.0"
+        mv "$input.0" "$input"
+        expected ${hash}sum '' >> "$file1"
+        ../ft_ssl $hash -q --per-record0 < "$input" >> "$file2"
+        tr '\0' '\n' < "$input" > "$input.0"
+        mv "$input.0" "$input"
+    done
+}
+
+echo Testing empty records
+printf "a\n\n\nb\n\n" > "$input"
+check
+
+echo Testing a missing final delimiter
+printf "first\nsecond\nlast" > "$input"
+check
+
+echo Testing a single record without delimiter
+printf "only" > "$input"
+check
+
+# 65536 byte reads, a delimiter as the last byte of a read, an empty
+# record right after it and records longer than a read
+echo Testing records across the 64 KiB read boundary
+{
+    head -c 65535 < /dev/zero | tr '\0' 'x'
+    printf "\n\n"
+    for i in $(seq 1 300)
+    do
+        head -c $((i * 97 % 1500)) < /dev/urandom | base64 -w 0
+        printf "\n"
+    done
+    head -c 150000 < /dev/urandom | base64 -w 0
+    printf "\nend"
+} > "$input"
+check
+
+diff -s "$file1" "$file2"
+
+rm "$file1" "$file2" "$input"
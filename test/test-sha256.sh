@@ -1,12 +1,14 @@
 file1=sha_test_1.txt
 file2=sha_test_2.txt
 random=sha_random.txt
+# another build can be given, like ../ft_ssl_portable from make portable
+ft_ssl=${1:-../ft_ssl}
 
-if [ -f "../ft_ssl" ]
+if [ -f "$ft_ssl" ]
 then
-    echo "Found ft_ssl"
+    echo "Found $ft_ssl"
 else
-    echo "Missing ft_ssl"
+    echo "Missing $ft_ssl"
     exit
 fi
 
@@ -20,7 +22,7 @@ do
     str=`./randstr $i`
     #sha256 -s "$str" >> "$file1"
     printf "$str" | shasum -a 256 | tr -d " -" >> "$file1"
-    ../ft_ssl sha256 -q -s "$str" >> "$file2"
+    "$ft_ssl" sha256 -q -s "$str" >> "$file2"
 done
 
 for i in $(seq 1001 2000)
@@ -29,7 +31,7 @@ do
     head -c $i < /dev/random > "$random"
     #sha256 -q "$random" >> "$file1"
     cat "$random" | shasum -a 256 | tr -d " -" >> "$file1"
-    ../ft_ssl sha256 -q "$random" >> "$file2"
+    "$ft_ssl" sha256 -q "$random" >> "$file2"
 done
 
 diff -s "$file1" "$file2"
@@ -0,0 +1,66 @@
+file1=sparse_test_1.txt
+file2=sparse_test_2.txt
+sparse=sparse_file.txt
+
+if [ -f "../ft_ssl" ]
+then
+    echo "Found ft_ssl"
+else
+    echo "Missing ft_ssl"
+    exit
+fi
+
+rm "$file1" "$file2" "$sparse" 2>/dev/null
+
+# a file is hashed with the hole aware reader and stdin with plain reads
+check()
+{
+    for hash in md5 sha256 blake2s blake2b blake3
+    do
+        cat "$sparse" | ../ft_ssl $hash -q >> "$file1"
+        ../ft_ssl $hash -q "$sparse" >> "$file2"
+    done
+}
+
+# write random bytes at a byte offset without truncating the file
+data()
+{
+    head -c $2 < /dev/urandom | dd of="$sparse" bs=1 seek=$1 conv=notrunc 2>/dev/null
+}
+
+echo Testing a hole at the start
+rm -f "$sparse"
+truncate -s 1000003 "$sparse"
+data 1000003 70001
+check
+
+echo Testing a hole in the middle
+rm -f "$sparse"
+data 0 5003
+truncate -s 3000017 "$sparse"
+data 3000017 4099
+check
+
+echo Testing a hole at the end
+rm -f "$sparse"
+data 0 12345
+truncate -s 2500001 "$sparse"
+check
+
+echo Testing several holes
+rm -f "$sparse"
+truncate -s 9000000 "$sparse"
+data 77 1000
+data 1048581 65539
+data 4194311 3
+data 8999999 1
+check
+
+echo Testing a file that is only a hole
+rm -f "$sparse"
+truncate -s 5000011 "$sparse"
+check
+
+diff -s "$file1" "$file2"
+
+rm "$file1" "$file2" "$sparse"